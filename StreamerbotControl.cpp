@@ -1,420 +1,404 @@
 #define IMGUI_DISABLE_INCLUDE_IMCONFIG_H
 #define WIN32_LEAN_AND_MEAN  // Prevent windows.h from including winsock.h
-#include <winsock2.h>        // Include winsock2.h FIRST
-#include <ws2tcpip.h>        // Include ws2tcpip.h second
-#include <windows.h>         // Now include windows.h
+#ifndef NOMINMAX
+#define NOMINMAX             // Keep windows.h from defining min/max macros over std::min/std::max
+#endif
+#include <windows.h>
 #include <imgui.h>
 #include <reshade.hpp>
+#include "core/command_engine.hpp"
+#include "core/log_ring.hpp"
+#include "core/server.hpp"
+#include "core/text.hpp"
+#include "core/transport.hpp"
 #include <string>
 #include <thread>
 #include <atomic>
 #include <mutex>
+#include <condition_variable>
+#include <random>
 #include <vector>
 #include <chrono>
-#include <sstream>
 #include <memory>
 #include <algorithm>
+#include <string_view>
+#include <cstdint>
+#include <charconv>
+#include <cstring>
 
-#pragma comment(lib, "ws2_32.lib")
+// The metrics panel and the supervisor call std::min/std::max; a header that pulls in windows.h
+// without NOMINMAX would turn them into macros
+#if defined(min) || defined(max)
+#error "min/max are macros here; define NOMINMAX before including windows.h"
+#endif
+
+using namespace streamerbot;
 
 // Addon info
 constexpr auto ADDON_NAME = "StreamerbotControl";
 constexpr auto ADDON_VERSION = "1.1";
 constexpr auto ADDON_AUTHOR = "LonelyViper";
 constexpr auto ADDON_COPYRIGHT = "Copyright (c) 2025 LonelyLabs";
-constexpr auto ADDON_DESCRIPTION = "Control ReShade effects via TCP commands from Streamerbot with auto-restart";
+constexpr auto ADDON_DESCRIPTION = "Control ReShade effects via TCP or WebSocket commands from Streamerbot with auto-restart";
 constexpr auto BUILD_DATE = __DATE__ " " __TIME__;
 constexpr int DEFAULT_PORT = 7777;
-constexpr size_t BUFFER_SIZE = 1024;
-constexpr size_t MAX_LOG_ENTRIES = 100;
+constexpr int DEFAULT_METRICS_PORT = 7778;
+constexpr int DEFAULT_OPERATOR_PORT = 7779;
+constexpr int DEFAULT_RATE_LIMIT = 100;         // Commands per second per client; 0 for no limit
+constexpr int RESTART_BACKOFF_BASE_MS = 250;     // First auto-restart delay, doubled per attempt
+constexpr auto STABLE_RUN_TIME = std::chrono::seconds(30);  // Uptime after which restart attempts are forgiven
+constexpr uint64_t LOG_FILTER_SCAN_PER_FRAME = 4096;    // Log entries the filter checks per frame
+
+// Adapts the ReShade runtime to the interface the command engine uses
+class ReShadeEffectRuntime final : public EffectRuntime {
+public:
+    explicit ReShadeEffectRuntime(reshade::api::effect_runtime* runtime) : runtime_(runtime) {}
+
+    void EnumerateTechniques(const std::function<void(TechniqueHandle technique, std::string_view name)>& callback) override {
+        runtime_->enumerate_techniques(nullptr, [&callback](reshade::api::effect_runtime* rt, reshade::api::effect_technique technique) {
+            char tech_name[256] = {};
+            rt->get_technique_name(technique, tech_name);
+            callback(technique.handle, tech_name);
+            });
+    }
+
+    bool GetTechniqueState(TechniqueHandle technique) override {
+        return runtime_->get_technique_state({ technique });
+    }
+
+    void SetTechniqueState(TechniqueHandle technique, bool enabled) override {
+        runtime_->set_technique_state({ technique }, enabled);
+    }
 
-struct LogEntry {
-    std::string message;
-    std::chrono::system_clock::time_point timestamp;
-    ImVec4 color;
+    void EnumerateUniforms(const std::function<void(UniformHandle variable, std::string_view effect_name,
+        std::string_view variable_name, const UniformType& type)>& callback) override {
+        runtime_->enumerate_uniform_variables(nullptr, [&callback](reshade::api::effect_runtime* rt, reshade::api::effect_uniform_variable variable) {
+            char effect_name[256] = {};
+            char variable_name[256] = {};
+            rt->get_uniform_variable_effect_name(variable, effect_name);
+            rt->get_uniform_variable_name(variable, variable_name);
+
+            reshade::api::format base_type = reshade::api::format::unknown;
+            UniformType type;
+            rt->get_uniform_variable_type(variable, &base_type, &type.rows, &type.columns, &type.array_length);
+            switch (base_type) {
+            case reshade::api::format::r32_sint: type.base = UniformBaseType::Int; break;
+            case reshade::api::format::r32_uint: type.base = UniformBaseType::Uint; break;
+            case reshade::api::format::r32_typeless: type.base = UniformBaseType::Bool; break;
+            default: type.base = UniformBaseType::Float; break;
+            }
+            callback(variable.handle, effect_name, variable_name, type);
+            });
+    }
+
+    void GetUniformValues(UniformHandle variable, bool* values, size_t count) override { runtime_->get_uniform_value_bool({ variable }, values, count); }
+    void GetUniformValues(UniformHandle variable, int32_t* values, size_t count) override { runtime_->get_uniform_value_int({ variable }, values, count); }
+    void GetUniformValues(UniformHandle variable, uint32_t* values, size_t count) override { runtime_->get_uniform_value_uint({ variable }, values, count); }
+    void GetUniformValues(UniformHandle variable, float* values, size_t count) override { runtime_->get_uniform_value_float({ variable }, values, count); }
+    void SetUniformValues(UniformHandle variable, const bool* values, size_t count) override { runtime_->set_uniform_value_bool({ variable }, values, count); }
+    void SetUniformValues(UniformHandle variable, const int32_t* values, size_t count) override { runtime_->set_uniform_value_int({ variable }, values, count); }
+    void SetUniformValues(UniformHandle variable, const uint32_t* values, size_t count) override { runtime_->set_uniform_value_uint({ variable }, values, count); }
+    void SetUniformValues(UniformHandle variable, const float* values, size_t count) override { runtime_->set_uniform_value_float({ variable }, values, count); }
+
+private:
+    reshade::api::effect_runtime* runtime_;
 };
 
 struct AddonState {
+    // Server core; the transport and server outlive individual server threads
+    LogRing log;
+    CommandEngine commands{ log };
+    std::unique_ptr<Transport> transport = CreatePlatformTransport();
+    Server server{ *transport, commands, log };
+
     // Network state
     std::atomic<bool> server_running{ false };
     std::atomic<bool> should_be_running{ false };  // NEW: Track intended states
-    std::unique_ptr<std::thread> server_thread;
+    std::unique_ptr<std::thread> server_thread;   // Guarded by server_thread_mutex
+    std::mutex server_thread_mutex;
     std::unique_ptr<std::thread> monitor_thread;   // NEW: Monitoring thread
-    SOCKET server_socket = INVALID_SOCKET;
     int port = DEFAULT_PORT;
-    std::mutex socket_mutex;
+    bool transport_started = false;               // Transport::Startup() succeeded; UI thread only
+    bool metrics_enabled = false;                 // Serve /metrics on 127.0.0.1:metrics_port
+    int metrics_port = DEFAULT_METRICS_PORT;
+    bool operator_enabled = false;                // Accept high priority command clients on operator_port
+    int operator_port = DEFAULT_OPERATOR_PORT;
+    int rate_limit = DEFAULT_RATE_LIMIT;          // Per-client commands per second, also the burst size
+    int low_priority_budget = DEFAULT_LOW_PRIORITY_BUDGET;
 
     // Connection state
-    std::atomic<bool> client_connected{ false };
-    std::string client_address = "None";
-    std::atomic<int> commands_received{ 0 };
     std::atomic<int> restart_count{ 0 };          // NEW: Track restart attempts.
 
     // Auto-restart settings
     bool auto_restart_enabled = true;             // NEW: Enable/disable auto-restart
-    int restart_delay_seconds = 5;               // NEW: Delay between restart attempts
+    int max_restart_delay_seconds = 30;          // Cap on the exponential restart backoff
     int max_restart_attempts = 10;               // NEW: Max consecutive restart attempts
-    std::chrono::steady_clock::time_point last_restart_attempt; // NEW: Track last restart
     std::chrono::steady_clock::time_point last_successful_start; // NEW: Track successful starts
 
     // Health monitoring
-    std::chrono::steady_clock::time_point last_heartbeat;       // NEW: Track server health
     std::atomic<bool> server_healthy{ true };    // NEW: Server health status
+    std::mutex supervisor_mutex;
+    std::condition_variable supervisor_wakeup;    // Signalled on server failure and on stop
+    bool server_failed = false;                   // Guarded by supervisor_mutex
 
     // ReShade state
-    reshade::api::effect_runtime* current_runtime{ nullptr };
-    std::vector<std::string> available_techniques;
+    std::atomic<reshade::api::effect_runtime*> current_runtime{ nullptr };
 
     // UI state
-    std::vector<LogEntry> log_entries;
-    std::mutex log_mutex;
+    char log_filter[64] = "";
+    std::string log_filter_indexed;               // Filter text log_filter_matches was built for
+    std::vector<uint64_t> log_filter_matches;     // Log indices matching the filter, oldest first
+    size_t log_filter_first = 0;                  // First match still retained by the ring
+    uint64_t log_filter_scanned = 0;              // Log entries before this index have been checked
     bool show_technique_list = false;
+    bool show_uniform_list = false;
     bool auto_scroll_log = true;
     char port_buffer[16] = "7777";
+    char metrics_port_buffer[16] = "7778";
+    char operator_port_buffer[16] = "7779";
     bool show_advanced_settings = false;          // NEW: Show advanced restart settings
 
-    // Command processing
-    std::chrono::steady_clock::time_point last_command_time;
+    // Throughput meter, sampled once per second by the overlay
+    std::chrono::steady_clock::time_point throughput_sample_time;
+    int throughput_sample_received = 0;
+    int throughput_sample_applied = 0;
+    float received_per_second = 0.0f;
+    float applied_per_second = 0.0f;
+    float peak_received_per_second = 0.0f;
 };
 
 static std::unique_ptr<AddonState> g_state;
 
-// Add log entry
-void AddLog(const std::string& message, const ImVec4& color = ImVec4(1.0f, 1.0f, 1.0f, 1.0f)) {
+// Add log entry; safe to call from any thread
+void AddLog(std::string_view message, const ImVec4& color = ImVec4(1.0f, 1.0f, 1.0f, 1.0f)) {
     if (!g_state) return;
-
-    std::lock_guard<std::mutex> lock(g_state->log_mutex);
-
-    LogEntry entry;
-    entry.message = message;
-    entry.timestamp = std::chrono::system_clock::now();
-    entry.color = color;
-
-    g_state->log_entries.push_back(entry);
-
-    // Keep log size reasonable
-    if (g_state->log_entries.size() > MAX_LOG_ENTRIES) {
-        g_state->log_entries.erase(g_state->log_entries.begin());
-    }
+    g_state->log.Write(message, LogColor{ color.x, color.y, color.z, color.w });
 }
 
-// Update available techniques
+// Rebuild the technique and uniform catalogs after effects were (re)loaded
 void UpdateAvailableTechniques(reshade::api::effect_runtime* runtime) {
     if (!runtime || !g_state) return;
 
-    g_state->available_techniques.clear();
-
-    runtime->enumerate_techniques(nullptr, [](reshade::api::effect_runtime* rt, reshade::api::effect_technique technique) {
-        char tech_name[256] = {};
-        rt->get_technique_name(technique, tech_name);
-        g_state->available_techniques.push_back(tech_name);
-        });
-
-    AddLog("Updated available techniques: " + std::to_string(g_state->available_techniques.size()) + " found",
-        ImVec4(0.7f, 0.7f, 1.0f, 1.0f));
-}
-
-// Process command
-void ProcessCommand(const std::string& command) {
-    if (!g_state || !g_state->current_runtime) {
-        AddLog("Error: No runtime available", ImVec4(1.0f, 0.0f, 0.0f, 1.0f));
-        return;
-    }
-
-    g_state->last_command_time = std::chrono::steady_clock::now();
-    g_state->commands_received++;
-
-    // Parse command: FORMAT: "TOGGLE <technique_name>" or "ENABLE <technique_name>" or "DISABLE <technique_name>"
-    std::istringstream iss(command);
-    std::string action, technique_name;
-
-    iss >> action;
-    std::getline(iss >> std::ws, technique_name); // Get rest of line as technique name
-
-    // Convert action to uppercase
-    std::transform(action.begin(), action.end(), action.begin(), ::toupper);
-
-    if (technique_name.empty()) {
-        AddLog("Error: No technique specified in command", ImVec4(1.0f, 0.5f, 0.0f, 1.0f));
-        return;
-    }
-
-    bool found = false;
-
-    g_state->current_runtime->enumerate_techniques(nullptr, [&](reshade::api::effect_runtime* rt, reshade::api::effect_technique technique) {
-        char tech_name[256] = {};
-        rt->get_technique_name(technique, tech_name);
-        std::string name(tech_name);
-
-        // Check for exact match or partial match
-        bool matches = (name == technique_name);
-        if (!matches) {
-            std::string name_lower = name;
-            std::string search_lower = technique_name;
-            std::transform(name_lower.begin(), name_lower.end(), name_lower.begin(), ::tolower);
-            std::transform(search_lower.begin(), search_lower.end(), search_lower.begin(), ::tolower);
-            matches = (name_lower.find(search_lower) != std::string::npos);
-        }
-
-        if (matches) {
-            found = true;
-            bool current_state = rt->get_technique_state(technique);
-            bool new_state = current_state;
-
-            if (action == "TOGGLE") {
-                new_state = !current_state;
-            }
-            else if (action == "ENABLE" || action == "ON") {
-                new_state = true;
-            }
-            else if (action == "DISABLE" || action == "OFF") {
-                new_state = false;
-            }
-            else {
-                AddLog("Unknown action: " + action, ImVec4(1.0f, 0.5f, 0.0f, 1.0f));
-                return;
-            }
-
-            rt->set_technique_state(technique, new_state);
-
-            std::string state_str = new_state ? "ON" : "OFF";
-            AddLog("Set " + name + " to " + state_str, ImVec4(0.0f, 1.0f, 0.0f, 1.0f));
-        }
-        });
-
-    if (!found) {
-        AddLog("Technique not found: " + technique_name, ImVec4(1.0f, 0.5f, 0.0f, 1.0f));
-    }
+    ReShadeEffectRuntime adapter(runtime);
+    g_state->commands.Rebuild(adapter);
 }
 
-// NEW: Clean shutdown of server
+// NEW: Clean shutdown of server. Server thread only.
 void CleanShutdownServer() {
-    if (g_state->server_socket != INVALID_SOCKET) {
-        closesocket(g_state->server_socket);
-        g_state->server_socket = INVALID_SOCKET;
-    }
+    g_state->server.Close();
     g_state->server_running = false;
     g_state->server_healthy = false;
-    g_state->client_connected = false;
-    g_state->client_address = "None";
 }
 
-// TCP Server thread
+// Wakes the supervisor when the server thread exits on its own. Server thread only.
+static void ReportServerExit(bool failed) {
+    if (!failed) return;
+    std::lock_guard<std::mutex> lock(g_state->supervisor_mutex);
+    g_state->server_failed = true;
+    g_state->supervisor_wakeup.notify_one();
+}
+
+// TCP Server thread. The listener and client connections outlive the thread: a restart
+// stops this loop and a new thread resumes serving them, so no connection is refused or
+// dropped in between. They are only closed on stop, on failure or when the port changed.
 void ServerThread() {
     AddLog("Server thread started", ImVec4(0.0f, 1.0f, 0.0f, 1.0f));
 
-    // Initialize Winsock
-    WSADATA wsaData;
-    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
-        AddLog("WSAStartup failed", ImVec4(1.0f, 0.0f, 0.0f, 1.0f));
-        g_state->server_healthy = false;
-        return;
+    if (g_state->server.IsOpen() && g_state->server.Port() != g_state->port) {
+        AddLog("Port changed, closing listener on port " + std::to_string(g_state->server.Port()), ImVec4(0.0f, 1.0f, 1.0f, 1.0f));
+        g_state->server.Close();
     }
 
-    // Create socket
-    g_state->server_socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-    if (g_state->server_socket == INVALID_SOCKET) {
-        AddLog("Socket creation failed", ImVec4(1.0f, 0.0f, 0.0f, 1.0f));
-        WSACleanup();
-        g_state->server_healthy = false;
-        return;
+    if (g_state->server.IsOpen()) {
+        AddLog("Resuming on port " + std::to_string(g_state->port) + " with " +
+            std::to_string(g_state->server.ClientsConnected()) + " client(s)", ImVec4(0.0f, 1.0f, 0.0f, 1.0f));
     }
-
-    // Set socket options
-    int opt = 1;
-    setsockopt(g_state->server_socket, SOL_SOCKET, SO_REUSEADDR, (char*)&opt, sizeof(opt));
-
-    // Set non-blocking mode
-    u_long mode = 1;
-    ioctlsocket(g_state->server_socket, FIONBIO, &mode);
-
-    // Bind socket
-    sockaddr_in server_addr = {};
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_addr.s_addr = INADDR_ANY;
-    server_addr.sin_port = htons(g_state->port);
-
-    if (bind(g_state->server_socket, (sockaddr*)&server_addr, sizeof(server_addr)) == SOCKET_ERROR) {
-        AddLog("Bind failed on port " + std::to_string(g_state->port), ImVec4(1.0f, 0.0f, 0.0f, 1.0f));
+    else if (!g_state->server.Open(g_state->port)) {
         CleanShutdownServer();
-        WSACleanup();
+        ReportServerExit(true);
         return;
     }
 
-    // Listen for connections
-    if (listen(g_state->server_socket, SOMAXCONN) == SOCKET_ERROR) {
-        AddLog("Listen failed", ImVec4(1.0f, 0.0f, 0.0f, 1.0f));
-        CleanShutdownServer();
-        WSACleanup();
-        return;
+    // Same for the operator port; audience commands keep flowing on the main port if it fails
+    if (g_state->server.OperatorOpen() && (!g_state->operator_enabled || g_state->server.OperatorPort() != g_state->operator_port)) {
+        g_state->server.CloseOperator();
+    }
+    if (g_state->operator_enabled && !g_state->server.OperatorOpen()) {
+        g_state->server.OpenOperator(g_state->operator_port);
     }
 
-    AddLog("Server listening on port " + std::to_string(g_state->port), ImVec4(0.0f, 1.0f, 0.0f, 1.0f));
+    // Bring the metrics endpoint in line with the settings. A metrics endpoint that fails to
+    // open does not stop the command server.
+    if (g_state->server.MetricsOpen() && (!g_state->metrics_enabled || g_state->server.MetricsPort() != g_state->metrics_port)) {
+        g_state->server.CloseMetrics();
+    }
+    if (g_state->metrics_enabled && !g_state->server.MetricsOpen()) {
+        g_state->server.OpenMetrics(g_state->metrics_port, [](MetricsWriter& metrics) {
+            metrics.Gauge("streamerbot_restart_count", "Consecutive automatic restart attempts.", (double)g_state->restart_count.load());
+            metrics.Gauge("streamerbot_server_healthy", "1 while the command server is healthy.", g_state->server_healthy ? 1.0 : 0.0);
+            });
+    }
 
     // Mark server as healthy and update timestamps
     g_state->server_healthy = true;
-    g_state->last_heartbeat = std::chrono::steady_clock::now();
     g_state->last_successful_start = std::chrono::steady_clock::now();
-    g_state->restart_count = 0; // Reset restart count on successful start
-
-    while (g_state->server_running && g_state->should_be_running) {
-        // Update heartbeat
-        g_state->last_heartbeat = std::chrono::steady_clock::now();
-
-        // Accept connections
-        sockaddr_in client_addr = {};
-        int client_len = sizeof(client_addr);
-        SOCKET client_socket = accept(g_state->server_socket, (sockaddr*)&client_addr, &client_len);
-
-        if (client_socket != INVALID_SOCKET) {
-            char addr_str[INET_ADDRSTRLEN];
-            inet_ntop(AF_INET, &client_addr.sin_addr, addr_str, INET_ADDRSTRLEN);
-            g_state->client_address = addr_str;
-            g_state->client_connected = true;
-
-            AddLog("Client connected from " + g_state->client_address, ImVec4(0.0f, 1.0f, 1.0f, 1.0f));
-
-            // Handle client
-            char buffer[BUFFER_SIZE];
-            while (g_state->server_running && g_state->should_be_running) {
-                // Update heartbeat during active connection
-                g_state->last_heartbeat = std::chrono::steady_clock::now();
-
-                int bytes_received = recv(client_socket, buffer, BUFFER_SIZE - 1, 0);
-
-                if (bytes_received > 0) {
-                    buffer[bytes_received] = '\0';
-                    std::string command(buffer);
-
-                    // Remove newlines/carriage returns
-                    command.erase(std::remove(command.begin(), command.end(), '\n'), command.end());
-                    command.erase(std::remove(command.begin(), command.end(), '\r'), command.end());
-
-                    AddLog("Received: " + command, ImVec4(0.8f, 0.8f, 1.0f, 1.0f));
-                    ProcessCommand(command);
-
-                    // Send acknowledgment
-                    std::string response = "OK\n";
-                    send(client_socket, response.c_str(), (int)response.length(), 0);
-                }
-                else if (bytes_received == 0) {
-                    // Client disconnected gracefully
-                    break;
-                }
-                else {
-                    // Check for actual error (not just non-blocking)
-                    int error = WSAGetLastError();
-                    if (error != WSAEWOULDBLOCK) {
-                        AddLog("Socket error: " + std::to_string(error), ImVec4(1.0f, 0.5f, 0.0f, 1.0f));
-                        break;
-                    }
-                }
-
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
-            }
 
-            g_state->client_connected = false;
-            g_state->client_address = "None";
-            closesocket(client_socket);
-            AddLog("Client disconnected", ImVec4(1.0f, 0.5f, 0.0f, 1.0f));
-        }
-        else {
-            // Check for socket errors that would indicate server failure
-            int error = WSAGetLastError();
-            if (error != WSAEWOULDBLOCK && error != WSAECONNABORTED) {
-                AddLog("Accept error: " + std::to_string(error), ImVec4(1.0f, 0.0f, 0.0f, 1.0f));
-                g_state->server_healthy = false;
-                break;
-            }
-        }
+    // Run() only returns true once it was asked to stop, so false means the server failed
+    bool ok = g_state->server.Run([] {
+        return g_state->server_running && g_state->should_be_running;
+        });
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    if (ok && g_state->should_be_running) {
+        // Restart: hand the open sockets to the next server thread
+        g_state->server_running = false;
+        AddLog("Server loop paused, keeping connections open", ImVec4(0.0f, 1.0f, 1.0f, 1.0f));
+        return;
     }
 
     CleanShutdownServer();
-    WSACleanup();
     AddLog("Server stopped", ImVec4(1.0f, 0.5f, 0.0f, 1.0f));
+    ReportServerExit(!ok);
 }
 
-// NEW: Server monitor and auto-restart thread
+// Starts the server thread unless one is already serving or the server was stopped. The
+// supervisor calls this outside supervisor_mutex, so StopServer() may have run in between;
+// checking should_be_running under server_thread_mutex keeps a stopped server stopped.
+static void LaunchServerThread() {
+    std::lock_guard<std::mutex> lock(g_state->server_thread_mutex);
+    if (g_state->server_running || !g_state->should_be_running) return;
+
+    // Reap a thread that already exited
+    if (g_state->server_thread && g_state->server_thread->joinable()) {
+        g_state->server_thread->join();
+    }
+    g_state->server_running = true;
+    g_state->server_thread = std::make_unique<std::thread>(ServerThread);
+}
+
+// Asks the server thread to stop and waits for it
+static void StopServerThread() {
+    std::lock_guard<std::mutex> lock(g_state->server_thread_mutex);
+    g_state->server_running = false;
+    g_state->server.Wake();
+    if (g_state->server_thread && g_state->server_thread->joinable()) {
+        g_state->server_thread->join();
+    }
+}
+
+// Delay before restart attempt n (1-based): doubles from RESTART_BACKOFF_BASE_MS up to
+// max_restart_delay_seconds. Half of it is randomized so that several game instances
+// fighting over one port do not retry in lockstep.
+static std::chrono::milliseconds RestartBackoff(int attempt, std::mt19937& rng) {
+    const int64_t cap_ms = (int64_t)g_state->max_restart_delay_seconds * 1000;
+    const int64_t delay_ms = std::min<int64_t>(cap_ms, (int64_t)RESTART_BACKOFF_BASE_MS << std::min(attempt - 1, 20));
+    std::uniform_int_distribution<int64_t> jitter(0, delay_ms / 2);
+    return std::chrono::milliseconds(delay_ms - delay_ms / 2 + jitter(rng));
+}
+
+// NEW: Server supervisor. Sleeps on a condition variable until the server thread reports a
+// failure or the server is stopped, so it never wakes while the server is healthy.
 void MonitorThread() {
     AddLog("Monitor thread started", ImVec4(0.0f, 0.8f, 0.8f, 1.0f));
 
-    while (g_state->should_be_running) {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+    std::mt19937 rng(std::random_device{}());
+    std::unique_lock<std::mutex> lock(g_state->supervisor_mutex);
+
+    while (true) {
+        g_state->supervisor_wakeup.wait(lock, [] { return !g_state->should_be_running || g_state->server_failed; });
+        if (!g_state->should_be_running) break;
+        g_state->server_failed = false;
 
         // Check if auto-restart is enabled
         if (!g_state->auto_restart_enabled) {
             continue;
         }
 
-        // Check if server should be running but isn't
-        if (g_state->should_be_running && !g_state->server_running) {
-            auto now = std::chrono::steady_clock::now();
-            auto time_since_last_restart = std::chrono::duration_cast<std::chrono::seconds>(
-                now - g_state->last_restart_attempt).count();
-
-            // Check if enough time has passed since last restart attempt
-            if (time_since_last_restart >= g_state->restart_delay_seconds) {
-                // Check if we haven't exceeded max restart attempts
-                if (g_state->restart_count < g_state->max_restart_attempts) {
-                    g_state->restart_count++;
-                    g_state->last_restart_attempt = now;
-
-                    AddLog("Auto-restarting server (attempt " + std::to_string(g_state->restart_count) +
-                        "/" + std::to_string(g_state->max_restart_attempts) + ")",
-                        ImVec4(1.0f, 1.0f, 0.0f, 1.0f));
-
-                    // Stop existing thread if it's still running
-                    if (g_state->server_thread && g_state->server_thread->joinable()) {
-                        g_state->server_thread->join();
-                    }
-
-                    // Start new server thread
-                    g_state->server_running = true;
-                    g_state->server_thread = std::make_unique<std::thread>(ServerThread);
-                }
-                else {
-                    AddLog("Max restart attempts reached. Auto-restart disabled.", ImVec4(1.0f, 0.0f, 0.0f, 1.0f));
-                    g_state->auto_restart_enabled = false;
-                }
-            }
+        // A server that stayed up for a while starts a fresh backoff sequence
+        if (std::chrono::steady_clock::now() - g_state->last_successful_start >= STABLE_RUN_TIME) {
+            g_state->restart_count = 0;
         }
+        if (g_state->restart_count >= g_state->max_restart_attempts) {
+            AddLog("Max restart attempts reached. Auto-restart disabled.", ImVec4(1.0f, 0.0f, 0.0f, 1.0f));
+            g_state->auto_restart_enabled = false;
+            continue;
+        }
+        g_state->restart_count++;
 
-        // Check server health (heartbeat)
-        if (g_state->server_running) {
-            auto now = std::chrono::steady_clock::now();
-            auto time_since_heartbeat = std::chrono::duration_cast<std::chrono::seconds>(
-                now - g_state->last_heartbeat).count();
-
-            // If no heartbeat for more than 30 seconds, consider server dead
-            if (time_since_heartbeat > 30) {
-                AddLog("Server heartbeat timeout - marking as unhealthy", ImVec4(1.0f, 0.5f, 0.0f, 1.0f));
-                g_state->server_healthy = false;
-
-                // Force stop the server to trigger restart
-                CleanShutdownServer();
-                if (g_state->server_thread && g_state->server_thread->joinable()) {
-                    g_state->server_thread->join();
-                }
-            }
+        std::chrono::milliseconds delay = RestartBackoff(g_state->restart_count, rng);
+        AddLog("Auto-restarting server in " + std::to_string(delay.count()) + " ms (attempt " +
+            std::to_string(g_state->restart_count) + "/" + std::to_string(g_state->max_restart_attempts) + ")",
+            ImVec4(1.0f, 1.0f, 0.0f, 1.0f));
+
+        // StopServer() cuts the wait short
+        if (g_state->supervisor_wakeup.wait_for(lock, delay, [] { return !g_state->should_be_running.load(); })) {
+            break;
         }
+
+        lock.unlock();
+        LaunchServerThread();
+        lock.lock();
     }
 
     AddLog("Monitor thread stopped", ImVec4(0.0f, 0.8f, 0.8f, 1.0f));
 }
 
+// Parses a port field. Logs an error and returns false unless it holds a number from 1 to 65535.
+static bool ParsePort(const char* text, const char* name, int& port) {
+    const char* end = text + strlen(text);
+    int value = 0;
+    auto [parsed_end, error] = std::from_chars(text, end, value);
+    if (error != std::errc() || parsed_end != end || value < 1 || value > 65535) {
+        AddLog(std::string("Invalid ") + name + " '" + text + "': expected a number from 1 to 65535", ImVec4(1.0f, 0.0f, 0.0f, 1.0f));
+        return false;
+    }
+    port = value;
+    return true;
+}
+
+struct PortSettings {
+    int port = DEFAULT_PORT;
+    int metrics_port = DEFAULT_METRICS_PORT;
+    int operator_port = DEFAULT_OPERATOR_PORT;
+};
+
+// Reads the port fields. Ports of disabled features are not checked and keep their value.
+static bool ReadPortSettings(PortSettings& ports) {
+    ports.metrics_port = g_state->metrics_port;
+    ports.operator_port = g_state->operator_port;
+    if (!ParsePort(g_state->port_buffer, "port", ports.port)) return false;
+    if (g_state->metrics_enabled && !ParsePort(g_state->metrics_port_buffer, "metrics port", ports.metrics_port)) return false;
+    if (g_state->operator_enabled && !ParsePort(g_state->operator_port_buffer, "operator port", ports.operator_port)) return false;
+    return true;
+}
+
 // Start server
 void StartServer() {
     if (!g_state) return;
 
-    g_state->port = std::stoi(g_state->port_buffer);
+    PortSettings ports;
+    if (!ReadPortSettings(ports)) {
+        AddLog("Server not started", ImVec4(1.0f, 0.0f, 0.0f, 1.0f));
+        return;
+    }
+    g_state->port = ports.port;
+    g_state->metrics_port = ports.metrics_port;
+    g_state->operator_port = ports.operator_port;
+    g_state->server.SetRateLimit(g_state->rate_limit, g_state->rate_limit);
+    // Networking is initialized once and stays up until the addon unloads
+    if (!g_state->transport_started) {
+        std::string error;
+        if (!g_state->transport->Startup(error)) {
+            AddLog(error, ImVec4(1.0f, 0.0f, 0.0f, 1.0f));
+            return;
+        }
+        g_state->transport_started = true;
+    }
+
     g_state->should_be_running = true;
-    g_state->server_running = true;
     g_state->restart_count = 0; // Reset restart count when manually started
 
     // Start server thread
-    g_state->server_thread = std::make_unique<std::thread>(ServerThread);
+    LaunchServerThread();
 
     // Start monitor thread if not already running
     if (!g_state->monitor_thread) {
@@ -426,21 +410,19 @@ void StartServer() {
 void StopServer() {
     if (!g_state) return;
 
-    g_state->should_be_running = false;
-    g_state->server_running = false;
-
-    // Close socket to unblock accept()
-    if (g_state->server_socket != INVALID_SOCKET) {
-        closesocket(g_state->server_socket);
-    }
-
-    if (g_state->server_thread && g_state->server_thread->joinable()) {
-        g_state->server_thread->join();
+    {
+        std::lock_guard<std::mutex> lock(g_state->supervisor_mutex);
+        g_state->should_be_running = false;
+        g_state->supervisor_wakeup.notify_one();
     }
 
+    // Join the supervisor first, so no restart can start a server thread behind our back
     if (g_state->monitor_thread && g_state->monitor_thread->joinable()) {
         g_state->monitor_thread->join();
     }
+    g_state->monitor_thread.reset();
+
+    StopServerThread();
 }
 
 // NEW: Manual restart function
@@ -449,22 +431,82 @@ void RestartServer() {
 
     AddLog("Manual server restart requested", ImVec4(0.0f, 1.0f, 1.0f, 1.0f));
 
-    // Stop server
-    g_state->server_running = false;
-    if (g_state->server_socket != INVALID_SOCKET) {
-        closesocket(g_state->server_socket);
-    }
-    if (g_state->server_thread && g_state->server_thread->joinable()) {
-        g_state->server_thread->join();
+    // Check the fields first, so a bad port leaves the running server alone
+    PortSettings ports;
+    if (!ReadPortSettings(ports)) {
+        AddLog("Server not restarted", ImVec4(1.0f, 0.0f, 0.0f, 1.0f));
+        return;
     }
 
+    // Stop the server loop; the listener and clients stay open for the new thread
+    StopServerThread();
+
     // Reset restart count for manual restart
     g_state->restart_count = 0;
 
     // Start server again
-    std::this_thread::sleep_for(std::chrono::milliseconds(500)); // Brief pause
-    g_state->server_running = true;
-    g_state->server_thread = std::make_unique<std::thread>(ServerThread);
+    g_state->port = ports.port;
+    g_state->metrics_port = ports.metrics_port;
+    g_state->operator_port = ports.operator_port;
+    LaunchServerThread();
+}
+
+// Recomputes the command rates once per second. UI thread only.
+static void UpdateThroughput() {
+    auto now = std::chrono::steady_clock::now();
+    float elapsed = std::chrono::duration<float>(now - g_state->throughput_sample_time).count();
+    if (elapsed < 1.0f) return;
+
+    int received = g_state->commands.CommandsReceived();
+    int applied = g_state->commands.CommandsApplied();
+    if (g_state->throughput_sample_time.time_since_epoch().count() != 0) {
+        g_state->received_per_second = (received - g_state->throughput_sample_received) / elapsed;
+        g_state->applied_per_second = (applied - g_state->throughput_sample_applied) / elapsed;
+        g_state->peak_received_per_second = std::max(g_state->peak_received_per_second, g_state->received_per_second);
+    }
+    g_state->throughput_sample_time = now;
+    g_state->throughput_sample_received = received;
+    g_state->throughput_sample_applied = applied;
+}
+
+// Brings the log filter index up to date. Only entries written since the previous frame
+// are scanned unless the filter text changed; a new filter scans the history a slice per
+// frame, so editing it never stalls a frame on the whole ring. UI thread only.
+static void UpdateLogFilterIndex(uint64_t log_begin, uint64_t log_end) {
+    std::string_view filter = g_state->log_filter;
+
+    if (filter != g_state->log_filter_indexed) {
+        g_state->log_filter_indexed.assign(filter.data(), filter.size());
+        g_state->log_filter_matches.clear();
+        g_state->log_filter_first = 0;
+        g_state->log_filter_scanned = log_begin;
+    }
+
+    // Forget matches the ring has overwritten
+    auto& matches = g_state->log_filter_matches;
+    while (g_state->log_filter_first < matches.size() && matches[g_state->log_filter_first] < log_begin) {
+        ++g_state->log_filter_first;
+    }
+    if (g_state->log_filter_first > matches.size() / 2) {
+        matches.erase(matches.begin(), matches.begin() + (ptrdiff_t)g_state->log_filter_first);
+        g_state->log_filter_first = 0;
+    }
+
+    LogEntry entry;
+    uint64_t index = std::max(g_state->log_filter_scanned, log_begin);
+    const uint64_t scan_end = std::min(log_end, index + LOG_FILTER_SCAN_PER_FRAME);
+    for (; index < scan_end; ++index) {
+        if (!g_state->log.Read(index, entry)) {
+            if (index >= g_state->log.End() - std::min<uint64_t>(g_state->log.End(), MAX_LOG_ENTRIES)) {
+                break; // Still being written; pick it up next frame
+            }
+            continue;  // Already overwritten
+        }
+        if (ContainsIgnoreCase(entry.Message(), filter)) {
+            matches.push_back(index);
+        }
+    }
+    g_state->log_filter_scanned = index;
 }
 
 // GUI
@@ -481,17 +523,126 @@ static void OnDrawSettings(reshade::api::effect_runtime* runtime) {
             g_state->server_healthy ? "(Healthy)" : "(Unhealthy)");
     }
 
-    ImGui::Text("Client: %s", g_state->client_connected.load() ? g_state->client_address.c_str() : "None");
-    ImGui::Text("Commands Received: %d", g_state->commands_received.load());
+    ImGui::Text("Clients: %d (last: %s)", g_state->server.ClientsConnected(), g_state->server.LastClientAddress().c_str());
+    ImGui::Text("Commands Received: %d", g_state->commands.CommandsReceived());
+    ImGui::Text("Queued: %d (high %d)  Dropped: %d  Coalesced: %d", (int)g_state->commands.Queued(),
+        (int)g_state->commands.Queued(CommandPriority::High), g_state->commands.CommandsDropped(),
+        g_state->commands.CommandsCoalesced());
+    UpdateThroughput();
+    ImGui::Text("Throughput: %.0f received/s  %.0f applied/s  (peak %.0f/s)",
+        g_state->received_per_second, g_state->applied_per_second, g_state->peak_received_per_second);
+    ImGui::Text("Frame: %llu (%.2f ms)", (unsigned long long)g_state->commands.Frames().Frame(), g_state->commands.Frames().FrameTimeMs());
+    ImGui::Text("Active Tweens: %d  Active Leases: %d  Scheduled: %d", g_state->commands.ActiveTweens(), g_state->commands.ActiveLeases(),
+        g_state->commands.ScheduledCommands());
 
     // NEW: Auto-restart status
     if (g_state->restart_count > 0) {
         ImGui::Text("Restart Count: %d/%d", g_state->restart_count.load(), g_state->max_restart_attempts);
     }
 
+    // Command latency per pipeline stage, from receive to the first present that shows it
+    if (ImGui::CollapsingHeader("Command Latency")) {
+        if (ImGui::BeginTable("LatencyTable", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_SizingStretchSame)) {
+            ImGui::TableSetupColumn("Stage");
+            ImGui::TableSetupColumn("Count");
+            ImGui::TableSetupColumn("p50 (us)");
+            ImGui::TableSetupColumn("p90 (us)");
+            ImGui::TableSetupColumn("p99 (us)");
+            ImGui::TableSetupColumn("Max (us)");
+            ImGui::TableHeadersRow();
+
+            for (size_t i = 0; i < (size_t)LatencyStage::Count; ++i) {
+                const LatencyStage stage = (LatencyStage)i;
+                const LatencySummary summary = g_state->commands.Latency(stage).Summarize();
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(LatencyStageName(stage));
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", (unsigned long long)summary.count);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", summary.p50_ns / 1000.0);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", summary.p90_ns / 1000.0);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", summary.p99_ns / 1000.0);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", summary.max_ns / 1000.0);
+            }
+            ImGui::EndTable();
+        }
+
+        if (ImGui::Button("Reset Latency")) {
+            g_state->commands.ResetLatency();
+            g_state->peak_received_per_second = 0.0f;
+            AddLog("Latency statistics reset", ImVec4(0.0f, 1.0f, 0.0f, 1.0f));
+        }
+    }
+
+    // Admission counters per connected client
+    if (ImGui::CollapsingHeader("Clients")) {
+        if (ImGui::BeginTable("ClientTable", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_SizingStretchSame)) {
+            ImGui::TableSetupColumn("Client");
+            ImGui::TableSetupColumn("Address");
+            ImGui::TableSetupColumn("Submitted");
+            ImGui::TableSetupColumn("Throttled");
+            ImGui::TableSetupColumn("Dropped");
+            ImGui::TableSetupColumn("Backlog");
+            ImGui::TableHeadersRow();
+
+            for (const ClientStats& client : g_state->server.ClientStatistics()) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%u", client.client_id);
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(client.address.c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", (unsigned long long)client.submitted);
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", (unsigned long long)client.throttled);
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", (unsigned long long)client.dropped);
+                ImGui::TableNextColumn();
+                ImGui::Text("%u", client.backlog);
+            }
+            ImGui::EndTable();
+        }
+    }
+
     ImGui::Separator();
 
     ImGui::InputText("Port", g_state->port_buffer, sizeof(g_state->port_buffer));
+    ImGui::Checkbox("Operator Listener", &g_state->operator_enabled);
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Commands from clients on this port skip ahead of audience commands; applies on next start");
+    }
+    if (g_state->operator_enabled) {
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(100.0f);
+        ImGui::InputText("Operator Port", g_state->operator_port_buffer, sizeof(g_state->operator_port_buffer));
+    }
+    if (ImGui::InputInt("Rate Limit", &g_state->rate_limit, 10, 100)) {
+        g_state->rate_limit = std::max(g_state->rate_limit, 0);
+        g_state->server.SetRateLimit(g_state->rate_limit, g_state->rate_limit);
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Commands per second each client may send, in bursts of up to the same number; 0 for no limit");
+    }
+    if (ImGui::InputInt("Low Priority Budget", &g_state->low_priority_budget, 16, 128)) {
+        g_state->low_priority_budget = std::max(g_state->low_priority_budget, 1);
+        g_state->commands.SetLowPriorityBudget(g_state->low_priority_budget);
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Audience commands applied per frame once operator commands are done");
+    }
+    ImGui::Checkbox("Metrics Endpoint", &g_state->metrics_enabled);
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Prometheus metrics at http://127.0.0.1:<port>/metrics; applies on next start");
+    }
+    if (g_state->metrics_enabled) {
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(100.0f);
+        ImGui::InputText("Metrics Port", g_state->metrics_port_buffer, sizeof(g_state->metrics_port_buffer));
+    }
 
     if (!g_state->server_running) {
         if (ImGui::Button("Start Server")) {
@@ -528,7 +679,7 @@ static void OnDrawSettings(reshade::api::effect_runtime* runtime) {
 
     if (g_state->show_advanced_settings) {
         ImGui::Indent();
-        ImGui::SliderInt("Restart Delay (seconds)", &g_state->restart_delay_seconds, 1, 60);
+        ImGui::SliderInt("Max Restart Delay (seconds)", &g_state->max_restart_delay_seconds, 1, 300);
         ImGui::SliderInt("Max Restart Attempts", &g_state->max_restart_attempts, 1, 50);
         if (ImGui::Button("Reset Restart Counter")) {
             g_state->restart_count = 0;
@@ -541,13 +692,14 @@ static void OnDrawSettings(reshade::api::effect_runtime* runtime) {
 
     // Available techniques
     if (ImGui::Button("Show Available Techniques")) {
-        UpdateAvailableTechniques(runtime);
         g_state->show_technique_list = !g_state->show_technique_list;
     }
 
     if (g_state->show_technique_list) {
         ImGui::BeginChild("TechniqueList", ImVec2(0, 150), true);
-        for (const auto& tech : g_state->available_techniques) {
+        const TechniqueCatalog& techniques = g_state->commands.Techniques();
+        for (size_t i = 0; i < techniques.Size(); ++i) {
+            const std::string& tech = techniques[i].name;
             if (ImGui::Selectable(tech.c_str())) {
                 ImGui::SetClipboardText(tech.c_str());
             }
@@ -558,30 +710,82 @@ static void OnDrawSettings(reshade::api::effect_runtime* runtime) {
         ImGui::EndChild();
     }
 
+    // Available uniforms
+    if (ImGui::Button("Show Available Uniforms")) {
+        g_state->show_uniform_list = !g_state->show_uniform_list;
+    }
+
+    if (g_state->show_uniform_list) {
+        ImGui::BeginChild("UniformList", ImVec2(0, 150), true);
+        const UniformCatalog& uniforms = g_state->commands.Uniforms();
+        for (size_t i = 0; i < uniforms.Size(); ++i) {
+            const std::string& name = uniforms[i].name;
+            if (ImGui::Selectable(name.c_str())) {
+                ImGui::SetClipboardText(name.c_str());
+            }
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Click to copy (%zu values)", uniforms[i].type.Components());
+            }
+        }
+        ImGui::EndChild();
+    }
+
     ImGui::Separator();
     ImGui::Text("Command Format: <ACTION> <technique_name>");
     ImGui::Text("Actions: TOGGLE, ENABLE/ON, DISABLE/OFF");
-    ImGui::Text("Example: TOGGLE MotionBlur");
+    ImGui::Text("Example: TOGGLE MotionBlur, ENABLE MotionBlur FOR 30s");
+    ImGui::Text("Uniforms: SET Vignette.fx/Radius 1.5, GET Vignette.fx/Radius");
+    ImGui::Text("Tweens: TWEEN Vignette.fx/Radius 0.2 1.5 2000ms easeOut");
+    ImGui::Text("Batches: BEGIN ... COMMIT, or DISABLE Bloom; ENABLE Vignette");
+    ImGui::Text("Scheduling: AT frame+60 ENABLE Bloom, AT t+250ms DISABLE Bloom");
+    ImGui::Text("Debounce: DEBOUNCE MotionBlur 500ms, DEBOUNCE MotionBlur off");
+    ImGui::Text("Priority: PRIORITY HIGH DISABLE Bloom");
 
     ImGui::Separator();
 
     // Log window
     ImGui::Text("Activity Log:");
     ImGui::Checkbox("Auto-scroll", &g_state->auto_scroll_log);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(200.0f);
+    ImGui::InputTextWithHint("##LogFilter", "Filter", g_state->log_filter, sizeof(g_state->log_filter));
 
     ImGui::BeginChild("LogWindow", ImVec2(0, 200), true);
 
-    std::lock_guard<std::mutex> lock(g_state->log_mutex);
-    for (const auto& entry : g_state->log_entries) {
-        auto time_t = std::chrono::system_clock::to_time_t(entry.timestamp);
-        struct tm timeinfo = {};
-        localtime_s(&timeinfo, &time_t);
-        char time_buffer[32];
-        strftime(time_buffer, sizeof(time_buffer), "[%H:%M:%S]", &timeinfo);
+    const uint64_t log_end = g_state->log.End();
+    const uint64_t log_begin = log_end > MAX_LOG_ENTRIES ? log_end - MAX_LOG_ENTRIES : 0;
 
-        ImGui::TextColored(ImVec4(0.5f, 0.5f, 0.5f, 1.0f), "%s", time_buffer);
+    // Only the rows in view are read and drawn, so the cost per frame does not grow with
+    // the history size. Entries overwritten mid-read still take a row to keep the layout.
+    LogEntry entry;
+    auto draw_entry = [&](uint64_t index) {
+        if (!g_state->log.Read(index, entry)) {
+            ImGui::TextUnformatted("");
+            return;
+        }
+        ImGui::TextColored(ImVec4(0.5f, 0.5f, 0.5f, 1.0f), "%s", entry.time_text);
         ImGui::SameLine();
-        ImGui::TextColored(entry.color, "%s", entry.message.c_str());
+        ImGui::TextColored(ImVec4(entry.color.r, entry.color.g, entry.color.b, entry.color.a), "%.*s", (int)entry.length, entry.message);
+    };
+
+    ImGuiListClipper clipper;
+    if (g_state->log_filter[0] == '\0') {
+        clipper.Begin((int)(log_end - log_begin));
+        while (clipper.Step()) {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+                draw_entry(log_begin + (uint64_t)row);
+            }
+        }
+    }
+    else {
+        UpdateLogFilterIndex(log_begin, log_end);
+        const size_t first = g_state->log_filter_first;
+        clipper.Begin((int)(g_state->log_filter_matches.size() - first));
+        while (clipper.Step()) {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+                draw_entry(g_state->log_filter_matches[first + (size_t)row]);
+            }
+        }
     }
 
     if (g_state->auto_scroll_log && ImGui::GetScrollY() >= ImGui::GetScrollMaxY()) {
@@ -600,11 +804,26 @@ static void OnInitEffectRuntime(reshade::api::effect_runtime* runtime) {
 
 static void OnDestroyEffectRuntime(reshade::api::effect_runtime* runtime) {
     if (!g_state) return;
-    if (g_state->current_runtime == runtime) {
-        g_state->current_runtime = nullptr;
+    reshade::api::effect_runtime* expected = runtime;
+    if (g_state->current_runtime.compare_exchange_strong(expected, nullptr)) {
+        g_state->commands.Clear();
     }
 }
 
+// Technique handles are invalidated by a reload, so the catalog is rebuilt here
+static void OnReloadedEffects(reshade::api::effect_runtime* runtime) {
+    if (!g_state || g_state->current_runtime.load(std::memory_order_relaxed) != runtime) return;
+    UpdateAvailableTechniques(runtime);
+}
+
+// Commands are applied here, once per frame on the render thread, so the network thread
+// never touches the runtime
+static void OnReshadePresent(reshade::api::effect_runtime* runtime) {
+    if (!g_state || g_state->current_runtime.load(std::memory_order_relaxed) != runtime) return;
+    ReShadeEffectRuntime adapter(runtime);
+    g_state->commands.Drain(adapter);
+}
+
 // Add-on init/cleanup
 extern "C" __declspec(dllexport) bool AddonInit(HMODULE, HMODULE) {
     g_state = std::make_unique<AddonState>();
@@ -615,6 +834,9 @@ extern "C" __declspec(dllexport) bool AddonInit(HMODULE, HMODULE) {
 extern "C" __declspec(dllexport) void AddonUninit(HMODULE, HMODULE) {
     if (!g_state) return;
     StopServer();
+    if (g_state->transport_started) {
+        g_state->transport->Cleanup();
+    }
     g_state.reset();
 }
 
@@ -625,10 +847,14 @@ BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD fdwReason, LPVOID) {
         if (!reshade::register_addon(hinstDLL)) return FALSE;
         reshade::register_event<reshade::addon_event::init_effect_runtime>(&OnInitEffectRuntime);
         reshade::register_event<reshade::addon_event::destroy_effect_runtime>(&OnDestroyEffectRuntime);
+        reshade::register_event<reshade::addon_event::reshade_reloaded_effects>(&OnReloadedEffects);
+        reshade::register_event<reshade::addon_event::reshade_present>(&OnReshadePresent);
         reshade::register_overlay(ADDON_NAME, &OnDrawSettings);
         break;
     case DLL_PROCESS_DETACH:
         reshade::unregister_overlay(ADDON_NAME, &OnDrawSettings);
+        reshade::unregister_event<reshade::addon_event::reshade_present>(&OnReshadePresent);
+        reshade::unregister_event<reshade::addon_event::reshade_reloaded_effects>(&OnReloadedEffects);
         reshade::unregister_event<reshade::addon_event::init_effect_runtime>(&OnInitEffectRuntime);
         reshade::unregister_event<reshade::addon_event::destroy_effect_runtime>(&OnDestroyEffectRuntime);
         reshade::unregister_addon(hinstDLL);
@@ -0,0 +1,195 @@
+#pragma once
+#include "command_engine.hpp"
+#include "latency_histogram.hpp"
+#include "loopback_transport.hpp"
+#include "mock_effect_runtime.hpp"
+#include "server.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace streamerbot {
+    namespace bench {
+
+        constexpr int BENCH_PORT = 7777;
+
+        // "--name value" command-line options; anything else is ignored
+        class Options {
+        public:
+            Options(int argc, char** argv) : argc_(argc), argv_(argv) {}
+
+            int64_t Int(const char* name, int64_t fallback) const {
+                const char* value = Find(name);
+                return value ? strtoll(value, nullptr, 10) : fallback;
+            }
+            double Double(const char* name, double fallback) const {
+                const char* value = Find(name);
+                return value ? strtod(value, nullptr) : fallback;
+            }
+            const char* String(const char* name, const char* fallback) const {
+                const char* value = Find(name);
+                return value ? value : fallback;
+            }
+            bool Flag(const char* name) const {
+                for (int i = 1; i < argc_; ++i) {
+                    if (strcmp(argv_[i], name) == 0) return true;
+                }
+                return false;
+            }
+
+        private:
+            const char* Find(const char* name) const {
+                for (int i = 1; i + 1 < argc_; ++i) {
+                    if (strcmp(argv_[i], name) == 0) return argv_[i + 1];
+                }
+                return nullptr;
+            }
+
+            int argc_;
+            char** argv_;
+        };
+
+        inline void PrintLatency(const char* label, const LatencySummary& summary) {
+            printf("  %-28s n=%-8llu p50=%9.1f us  p90=%9.1f us  p99=%9.1f us  max=%9.1f us\n", label,
+                (unsigned long long)summary.count, summary.p50_ns / 1e3, summary.p90_ns / 1e3, summary.p99_ns / 1e3, summary.max_ns / 1e3);
+        }
+
+        // Reads one reply line from a client endpoint, spinning until it arrives. buffer keeps
+        // bytes past the line for the next call. Returns false on timeout or when the server
+        // closed the connection.
+        inline bool ReadLine(Transport& transport, SocketHandle socket, std::string& buffer, std::string& line,
+            int64_t timeout_ns = 10000000000) {
+            const int64_t deadline = MonotonicNs() + timeout_ns;
+            while (true) {
+                size_t nl = buffer.find('\n');
+                if (nl != std::string::npos) {
+                    line.assign(buffer, 0, nl);
+                    buffer.erase(0, nl + 1);
+                    return true;
+                }
+
+                char chunk[4096];
+                IoResult received = transport.Recv(socket, chunk, sizeof(chunk));
+                if (received.status == IoStatus::Ok) {
+                    buffer.append(chunk, received.bytes);
+                    continue;
+                }
+                if (received.status != IoStatus::WouldBlock || MonotonicNs() > deadline) return false;
+                std::this_thread::yield();
+            }
+        }
+
+        enum class TransportKind {
+            Loopback,   // In-process, no network stack
+            Platform,   // Real TCP sockets on 127.0.0.1
+        };
+
+        // Command server, engine and mock runtime wired together over a transport. The server
+        // runs on its own thread, and a render thread presents frames at a fixed rate the way
+        // a game would.
+        class BenchHost {
+        public:
+            BenchHost(int techniques, double fps, const MockEffectRuntime::Latencies& latencies = {},
+                TransportKind kind = TransportKind::Loopback, int port = BENCH_PORT)
+                : kind_(kind),
+                  transport_(kind == TransportKind::Loopback ? std::make_unique<LoopbackTransport>() : CreatePlatformTransport()),
+                  server_(*transport_, commands_, Log()),
+                  port_(port) {
+                for (int i = 0; i < techniques; ++i) {
+                    runtime_.AddTechnique("Technique" + std::to_string(i));
+                }
+                runtime_.SetLatencies(latencies);
+                runtime_.Reload(commands_);
+
+                opened_ = server_.Open(port_);
+                server_thread_ = std::thread([this] { server_.Run([this] { return running_.load(); }); });
+                frame_time_ = std::chrono::nanoseconds((int64_t)(1e9 / fps));
+                render_thread_ = std::thread([this] {
+                    auto next_frame = std::chrono::steady_clock::now();
+                    while (running_.load()) {
+                        next_frame += frame_time_;
+                        std::this_thread::sleep_until(next_frame);
+                        runtime_.Present(commands_);
+                    }
+                });
+            }
+
+            ~BenchHost() {
+                running_ = false;
+                server_.Wake();
+                server_thread_.join();
+                render_thread_.join();
+                server_.Close();
+            }
+
+            bool Opened() const { return opened_; }
+            streamerbot::Transport& Transport() { return *transport_; }
+            CommandEngine& Commands() { return commands_; }
+            Server& CommandServer() { return server_; }
+            SocketHandle Connect() { return Connect(port_); }
+
+            // Opens a non-blocking client connection to port on this host's transport.
+            // Returns INVALID_SOCKET_HANDLE on failure.
+            SocketHandle Connect(int port) {
+                if (kind_ == TransportKind::Loopback) return static_cast<LoopbackTransport&>(*transport_).Connect(port);
+#ifndef _WIN32
+                int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+                if (fd < 0) return INVALID_SOCKET_HANDLE;
+                sockaddr_in address = {};
+                address.sin_family = AF_INET;
+                address.sin_port = htons((uint16_t)port);
+                address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                if (connect(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+                    close(fd);
+                    return INVALID_SOCKET_HANDLE;
+                }
+                int no_delay = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+                return (SocketHandle)fd;
+#else
+                return INVALID_SOCKET_HANDLE;
+#endif
+            }
+            // Waits until the engine queue is empty and the last commands applied reached the screen
+            void Settle() const {
+                while (commands_.Queued() > 0) {
+                    std::this_thread::sleep_for(frame_time_);
+                }
+                std::this_thread::sleep_for(frame_time_ * 2);
+            }
+
+        private:
+            static LogRing& Log() {
+                static LogRing log;
+                return log;
+            }
+
+            TransportKind kind_;
+            std::unique_ptr<streamerbot::Transport> transport_;
+            MockEffectRuntime runtime_;
+            CommandEngine commands_{ Log() };
+            Server server_;
+            int port_;
+            bool opened_ = false;
+            std::chrono::nanoseconds frame_time_{ 0 };
+            std::atomic<bool> running_{ true };
+            std::thread server_thread_;
+            std::thread render_thread_;
+        };
+
+    }
+}
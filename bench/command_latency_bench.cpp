@@ -0,0 +1,151 @@
+// End-to-end command latency of the readiness-based server loop, next to the sleep-polling
+// accept/recv loop the addon used before it. Both serve the same loopback transport, engine
+// and mock runtime; clients send a command, wait for its reply and send the next.
+//
+//   command_latency_bench [--clients 4] [--commands 400] [--fps 144] [--connect-per-command]
+//
+// --connect-per-command opens a connection for every command, like the README's C# sample.
+#include "bench_host.hpp"
+#include <algorithm>
+#include <vector>
+
+using namespace streamerbot;
+using namespace streamerbot::bench;
+
+namespace {
+    constexpr int TECHNIQUES = 32;
+
+    // The accept/recv loop the addon shipped with, over the Transport interface: one client
+    // at a time, 100 ms of sleep between accept attempts and 10 ms between reads. Every read
+    // is one command and gets an "OK".
+    class PollingServer {
+    public:
+        PollingServer(Transport& transport, CommandEngine& commands) : transport_(transport), commands_(commands) {
+            std::string error;
+            listener_ = transport_.Listen(BENCH_PORT + 1, false, error);
+            thread_ = std::thread([this] { Run(); });
+        }
+
+        ~PollingServer() {
+            running_ = false;
+            thread_.join();
+            transport_.Close(listener_);
+        }
+
+    private:
+        void Run() {
+            while (running_) {
+                SocketHandle client = INVALID_SOCKET_HANDLE;
+                std::string address;
+                if (transport_.Accept(listener_, client, address).status != IoStatus::Ok) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                    continue;
+                }
+
+                char buffer[BUFFER_SIZE];
+                while (running_) {
+                    IoResult received = transport_.Recv(client, buffer, BUFFER_SIZE - 1);
+                    if (received.status == IoStatus::Ok) {
+                        std::string command(buffer, received.bytes);
+                        command.erase(std::remove(command.begin(), command.end(), '\n'), command.end());
+                        command.erase(std::remove(command.begin(), command.end(), '\r'), command.end());
+                        commands_.Submit(command, MonotonicNs());
+                        transport_.Send(client, "OK\n", 3);
+                    }
+                    else if (received.status != IoStatus::WouldBlock) {
+                        break;
+                    }
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                }
+                transport_.Close(client);
+            }
+        }
+
+        Transport& transport_;
+        CommandEngine& commands_;
+        SocketHandle listener_ = INVALID_SOCKET_HANDLE;
+        std::atomic<bool> running_{ true };
+        std::thread thread_;
+    };
+
+    struct Workload {
+        int clients;
+        int commands_per_client;
+        bool connect_per_command;
+    };
+
+    // Runs the workload against the server on port and records each command's round trip
+    bool RunClients(BenchHost& host, int port, const Workload& workload, LatencyHistogram& round_trips) {
+        std::atomic<int> failures{ 0 };
+        std::vector<std::thread> clients;
+        for (int c = 0; c < workload.clients; ++c) {
+            clients.emplace_back([&, c] {
+                Transport& transport = host.Transport();
+                SocketHandle socket = INVALID_SOCKET_HANDLE;
+                std::string buffer, reply;
+                for (int i = 0; i < workload.commands_per_client; ++i) {
+                    const std::string command = "TOGGLE Technique" + std::to_string((c * 7 + i) % TECHNIQUES) + "\n";
+                    const int64_t start = MonotonicNs();
+                    if (socket == INVALID_SOCKET_HANDLE) {
+                        socket = host.Connect(port);
+                        buffer.clear();
+                    }
+                    transport.Send(socket, command.data(), command.size());
+                    if (!ReadLine(transport, socket, buffer, reply, 60000000000) || reply != "OK") {
+                        failures++;
+                        break;
+                    }
+                    round_trips.Record(MonotonicNs() - start);
+                    if (workload.connect_per_command) {
+                        transport.Close(socket);
+                        socket = INVALID_SOCKET_HANDLE;
+                    }
+                }
+                if (socket != INVALID_SOCKET_HANDLE) transport.Close(socket);
+            });
+        }
+        for (std::thread& client : clients) {
+            client.join();
+        }
+        return failures == 0;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options(argc, argv);
+    Workload workload;
+    workload.clients = (int)std::max<int64_t>(options.Int("--clients", 4), 1);
+    workload.commands_per_client = (int)std::max<int64_t>(options.Int("--commands", 400) / workload.clients, 1);
+    workload.connect_per_command = options.Flag("--connect-per-command");
+    const double fps = options.Double("--fps", 144.0);
+
+    printf("%d clients x %d commands, %s, %.0f fps\n", workload.clients, workload.commands_per_client,
+        workload.connect_per_command ? "one connection per command" : "persistent connections", fps);
+
+    bool ok = true;
+    {
+        BenchHost host(TECHNIQUES, fps);
+        LatencyHistogram round_trips;
+        ok = RunClients(host, BENCH_PORT, workload, round_trips) && ok;
+        host.Settle();
+        printf("Event loop\n");
+        PrintLatency("send -> reply", round_trips.Summarize());
+        PrintLatency("receive -> on screen", host.Commands().Latency(LatencyStage::Total).Summarize());
+    }
+    {
+        BenchHost host(TECHNIQUES, fps);
+        PollingServer polling(host.Transport(), host.Commands());
+        LatencyHistogram round_trips;
+        ok = RunClients(host, BENCH_PORT + 1, workload, round_trips) && ok;
+        host.Settle();
+        printf("Polling loop (before the event loop)\n");
+        PrintLatency("send -> reply", round_trips.Summarize());
+        PrintLatency("receive -> on screen", host.Commands().Latency(LatencyStage::Total).Summarize());
+    }
+
+    if (!ok) {
+        printf("FAILED: commands went unanswered\n");
+        return 1;
+    }
+    return 0;
+}
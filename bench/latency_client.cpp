@@ -0,0 +1,138 @@
+// Command latency benchmark for a running addon. Sends TOGGLE commands over TCP, waits for
+// each acknowledgement and prints round-trip percentiles. Run it once against a build with
+// the old polling server loop and once against the current one to compare them.
+//
+//   latency_client [--host 127.0.0.1] [--port 7777] [--commands 500] [--technique Bloom]
+//                  [--connect-per-command]
+//
+// --connect-per-command opens a connection for every command, like the Streamerbot C# sample.
+//
+// Build:  g++ -O2 -std=c++17 bench/latency_client.cpp -o latency_client
+//         cl /O2 /std:c++17 /EHsc bench\latency_client.cpp ws2_32.lib
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+using Socket = SOCKET;
+constexpr Socket BAD_SOCKET = INVALID_SOCKET;
+static void CloseSocket(Socket socket) { closesocket(socket); }
+#else
+using Socket = int;
+constexpr Socket BAD_SOCKET = -1;
+static void CloseSocket(Socket socket) { close(socket); }
+#endif
+
+// "--name value" options; anything else is ignored
+static const char* FindOption(int argc, char** argv, const char* name, const char* fallback) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (strcmp(argv[i], name) == 0) return argv[i + 1];
+    }
+    return fallback;
+}
+
+static bool HasFlag(int argc, char** argv, const char* name) {
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], name) == 0) return true;
+    }
+    return false;
+}
+
+static Socket Connect(const char* host, int port) {
+    Socket socket_handle = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (socket_handle == BAD_SOCKET) return BAD_SOCKET;
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons((unsigned short)port);
+    inet_pton(AF_INET, host, &address.sin_addr);
+    if (connect(socket_handle, (sockaddr*)&address, sizeof(address)) != 0) {
+        CloseSocket(socket_handle);
+        return BAD_SOCKET;
+    }
+
+    int no_delay = 1;
+    setsockopt(socket_handle, IPPROTO_TCP, TCP_NODELAY, (const char*)&no_delay, sizeof(no_delay));
+    return socket_handle;
+}
+
+// Reads up to and including the next newline. Returns false if the connection closed first.
+static bool ReadReply(Socket socket_handle, std::string& reply) {
+    reply.clear();
+    char c;
+    while (recv(socket_handle, &c, 1, 0) == 1) {
+        if (c == '\n') return true;
+        if (c != '\r') reply += c;
+    }
+    return false;
+}
+
+static double Percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) return 0.0;
+    size_t index = (size_t)(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+int main(int argc, char** argv) {
+#if defined(_WIN32)
+    WSADATA wsa_data;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) return 1;
+#endif
+    const char* host = FindOption(argc, argv, "--host", "127.0.0.1");
+    const int port = atoi(FindOption(argc, argv, "--port", "7777"));
+    const int commands = std::max(atoi(FindOption(argc, argv, "--commands", "500")), 1);
+    const std::string line = std::string("TOGGLE ") + FindOption(argc, argv, "--technique", "Bloom") + "\n";
+    const bool connect_per_command = HasFlag(argc, argv, "--connect-per-command");
+
+    std::vector<double> round_trips_us;
+    Socket socket_handle = BAD_SOCKET;
+    std::string reply;
+    for (int i = 0; i < commands; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        if (socket_handle == BAD_SOCKET) {
+            socket_handle = Connect(host, port);
+            if (socket_handle == BAD_SOCKET) {
+                printf("Could not connect to %s:%d\n", host, port);
+                return 1;
+            }
+        }
+        if (send(socket_handle, line.data(), (int)line.size(), 0) != (int)line.size() || !ReadReply(socket_handle, reply)) {
+            printf("Connection lost after %d commands\n", i);
+            return 1;
+        }
+        const auto end = std::chrono::steady_clock::now();
+        round_trips_us.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+
+        if (connect_per_command) {
+            CloseSocket(socket_handle);
+            socket_handle = BAD_SOCKET;
+        }
+    }
+    if (socket_handle != BAD_SOCKET) CloseSocket(socket_handle);
+
+    std::sort(round_trips_us.begin(), round_trips_us.end());
+    printf("%d commands to %s:%d, %s\n", commands, host, port,
+        connect_per_command ? "one connection per command" : "one connection");
+    printf("  round trip  p50=%.1f us  p90=%.1f us  p99=%.1f us  max=%.1f us\n", Percentile(round_trips_us, 0.50),
+        Percentile(round_trips_us, 0.90), Percentile(round_trips_us, 0.99), round_trips_us.back());
+#if defined(_WIN32)
+    WSACleanup();
+#endif
+    return 0;
+}
@@ -0,0 +1,291 @@
+// Load generator for the command server. Runs the server, engine and mock runtime in process
+// and drives them with a TOGGLE/ENABLE/DISABLE mix from one client thread, over the loopback
+// transport or real TCP sockets on 127.0.0.1.
+//
+//   load_generator [--transport loopback|tcp] [--port 7777] [--connections 8]
+//                  [--connect-per-command] [--rate 0] [--duration 5] [--window 1]
+//                  [--toggle 60] [--enable 20] [--disable 20] [--techniques 64]
+//                  [--fps 144] [--apply-us 0] [--rate-limit 0] [--burst 0]
+//
+// --rate is commands per second over all connections; 0 sends as fast as replies come back,
+// with --window commands outstanding per connection. --apply-us makes every technique state
+// change in the mock runtime take that long. --rate-limit and --burst set the server's
+// per-client limit. Latency is measured from send to reply, pairing each connection's replies
+// with its commands in order; a reply to a dropped command can overtake earlier backlogged
+// ones, so with drops the percentiles are approximate.
+#include "bench_host.hpp"
+#include <deque>
+#include <vector>
+
+using namespace streamerbot;
+using namespace streamerbot::bench;
+
+namespace {
+    constexpr int64_t DRAIN_TIMEOUT_NS = 2000000000;   // After the run, give up on replies once none came for this long
+
+    struct Session {
+        SocketHandle socket = INVALID_SOCKET_HANDLE;
+        std::deque<int64_t> sent_ns;    // Send times of commands awaiting a reply
+        std::string buffer;
+        int64_t commands = 0;           // Commands sent on this connection
+    };
+
+    struct Counters {
+        uint64_t sent = 0;
+        uint64_t ok = 0;
+        uint64_t rate_limited = 0;      // "ERROR rate limited": the server dropped the command
+        uint64_t busy = 0;              // "ERROR busy": the engine queue was full
+        uint64_t other_errors = 0;
+        uint64_t connect_failures = 0;
+        uint64_t unanswered = 0;
+    };
+
+    // Weighted TOGGLE/ENABLE/DISABLE commands over numbered techniques, from a fixed seed
+    class CommandMix {
+    public:
+        CommandMix(int toggle, int enable, int disable, int techniques)
+            : toggle_(std::max(toggle, 0)), enable_(std::max(enable, 0)), disable_(std::max(disable, 0)), techniques_(techniques) {
+            if (toggle_ + enable_ + disable_ == 0) toggle_ = 1;
+        }
+
+        const std::string& Next() {
+            const uint32_t pick = NextRandom() % (uint32_t)(toggle_ + enable_ + disable_);
+            const char* action = pick < (uint32_t)toggle_ ? "TOGGLE" : pick < (uint32_t)(toggle_ + enable_) ? "ENABLE" : "DISABLE";
+            line_ = action;
+            line_ += " Technique";
+            line_ += std::to_string(NextRandom() % (uint32_t)techniques_);
+            line_ += '\n';
+            return line_;
+        }
+
+    private:
+        uint32_t NextRandom() {
+            state_ ^= state_ << 13;
+            state_ ^= state_ >> 17;
+            state_ ^= state_ << 5;
+            return state_;
+        }
+
+        int toggle_, enable_, disable_, techniques_;
+        uint32_t state_ = 2463534242u;
+        std::string line_;
+    };
+
+    class LoadGenerator {
+    public:
+        LoadGenerator(BenchHost& host, const Options& options)
+            : host_(host),
+              mix_((int)options.Int("--toggle", 60), (int)options.Int("--enable", 20), (int)options.Int("--disable", 20),
+                  (int)std::max<int64_t>(options.Int("--techniques", 64), 1)),
+              connections_((int)std::max<int64_t>(options.Int("--connections", 8), 1)),
+              window_((int)std::max<int64_t>(options.Int("--window", 1), 1)),
+              connect_per_command_(options.Flag("--connect-per-command")),
+              rate_(std::max(options.Double("--rate", 0.0), 0.0)) {}
+
+        void Run(int64_t duration_ns) {
+            if (!connect_per_command_) {
+                for (int i = 0; i < connections_; ++i) {
+                    Session session;
+                    session.socket = host_.Connect();
+                    if (session.socket == INVALID_SOCKET_HANDLE) {
+                        counters_.connect_failures++;
+                        continue;
+                    }
+                    sessions_.push_back(std::move(session));
+                }
+            }
+
+            const int64_t start = MonotonicNs();
+            const int64_t end = start + duration_ns;
+            int64_t next_send = start;
+            size_t next_session = 0;
+            int64_t now = start;
+            while (now < end && (connect_per_command_ || !sessions_.empty())) {
+                if (rate_ > 0) {
+                    // Open loop: commands leave on schedule whether or not replies keep up
+                    while (next_send <= now) {
+                        next_send += (int64_t)(1e9 / rate_);
+                        if (!Send(PickSession(next_session), now)) break;
+                    }
+                }
+                else if (connect_per_command_) {
+                    while ((int)sessions_.size() < connections_ && Send(PickSession(next_session), now)) {}
+                }
+                else {
+                    for (size_t i = 0; i < sessions_.size(); ++i) {
+                        while ((int)sessions_[i].sent_ns.size() < window_ && Send(i, now)) {}
+                    }
+                }
+
+                if (!Receive()) std::this_thread::yield();
+                now = MonotonicNs();
+            }
+            elapsed_ns_ = now - start;
+
+            // Backlogged commands keep trickling in at the rate limit
+            int64_t last_reply = MonotonicNs();
+            while (Outstanding() > 0 && MonotonicNs() - last_reply < DRAIN_TIMEOUT_NS) {
+                if (Receive()) last_reply = MonotonicNs();
+                else std::this_thread::yield();
+            }
+            for (Session& session : sessions_) {
+                counters_.unanswered += session.sent_ns.size();
+                host_.Transport().Close(session.socket);
+            }
+            sessions_.clear();
+        }
+
+        void Report() const {
+            const double seconds = elapsed_ns_ / 1e9;
+            printf("Sent %llu commands in %.2f s\n", (unsigned long long)counters_.sent, seconds);
+            printf("  %-28s %.0f commands/s\n", "accepted", counters_.ok / seconds);
+            printf("  %-28s %llu\n", "OK replies", (unsigned long long)counters_.ok);
+            printf("  %-28s %llu\n", "dropped: rate limited", (unsigned long long)counters_.rate_limited);
+            printf("  %-28s %llu\n", "dropped: engine busy", (unsigned long long)counters_.busy);
+            printf("  %-28s %llu\n", "other errors", (unsigned long long)counters_.other_errors);
+            printf("  %-28s %llu\n", "unanswered", (unsigned long long)counters_.unanswered);
+            printf("  %-28s %llu\n", "failed connects", (unsigned long long)counters_.connect_failures);
+            PrintLatency("send -> reply", round_trips_.Summarize());
+        }
+
+        bool Healthy() const {
+            return counters_.ok > 0 && counters_.unanswered == 0 && counters_.other_errors == 0 && counters_.connect_failures == 0;
+        }
+
+    private:
+        // A persistent connection in round-robin order, or a new one per command
+        size_t PickSession(size_t& next_session) {
+            if (!connect_per_command_) return next_session++ % sessions_.size();
+            sessions_.emplace_back();
+            return sessions_.size() - 1;
+        }
+
+        // Sends the next command of the mix. Returns false if the connection failed.
+        bool Send(size_t index, int64_t now) {
+            Session& session = sessions_[index];
+            if (session.socket == INVALID_SOCKET_HANDLE) {
+                session.socket = host_.Connect();
+                if (session.socket == INVALID_SOCKET_HANDLE) {
+                    counters_.connect_failures++;
+                    sessions_.erase(sessions_.begin() + index);
+                    return false;
+                }
+            }
+            const std::string& line = mix_.Next();
+            if (!SendAll(session.socket, line)) {
+                counters_.other_errors++;
+                return false;
+            }
+            session.sent_ns.push_back(now);
+            session.commands++;
+            counters_.sent++;
+            return true;
+        }
+
+        bool SendAll(SocketHandle socket, const std::string& line) {
+            size_t offset = 0;
+            while (offset < line.size()) {
+                IoResult sent = host_.Transport().Send(socket, line.data() + offset, line.size() - offset);
+                if (sent.status == IoStatus::Ok) offset += sent.bytes;
+                else if (sent.status == IoStatus::WouldBlock) std::this_thread::yield();
+                else return false;
+            }
+            return true;
+        }
+
+        // Reads every reply available now. Returns false if there was none.
+        bool Receive() {
+            bool received_any = false;
+            for (size_t i = 0; i < sessions_.size();) {
+                Session& session = sessions_[i];
+                char chunk[4096];
+                IoResult received = host_.Transport().Recv(session.socket, chunk, sizeof(chunk));
+                if (received.status == IoStatus::Ok) {
+                    received_any = true;
+                    session.buffer.append(chunk, received.bytes);
+                    ConsumeReplies(session);
+                }
+                const bool closed = received.status == IoStatus::Closed || received.status == IoStatus::Error;
+                const bool finished = connect_per_command_ && session.commands > 0 && session.sent_ns.empty();
+                if (closed || finished) {
+                    counters_.unanswered += session.sent_ns.size();
+                    host_.Transport().Close(session.socket);
+                    sessions_.erase(sessions_.begin() + i);
+                    continue;
+                }
+                ++i;
+            }
+            return received_any;
+        }
+
+        void ConsumeReplies(Session& session) {
+            const int64_t now = MonotonicNs();
+            size_t nl;
+            while ((nl = session.buffer.find('\n')) != std::string::npos) {
+                std::string_view reply(session.buffer.data(), nl);
+                if (!reply.empty() && reply.back() == '\r') reply.remove_suffix(1);
+                if (reply == "OK") counters_.ok++;
+                else if (reply == "ERROR rate limited") counters_.rate_limited++;
+                else if (reply == "ERROR busy") counters_.busy++;
+                else counters_.other_errors++;
+
+                if (!session.sent_ns.empty()) {
+                    round_trips_.Record(now - session.sent_ns.front());
+                    session.sent_ns.pop_front();
+                }
+                session.buffer.erase(0, nl + 1);
+            }
+        }
+
+        size_t Outstanding() const {
+            size_t outstanding = 0;
+            for (const Session& session : sessions_) {
+                outstanding += session.sent_ns.size();
+            }
+            return outstanding;
+        }
+
+        BenchHost& host_;
+        CommandMix mix_;
+        int connections_;
+        int window_;
+        bool connect_per_command_;
+        double rate_;
+        std::vector<Session> sessions_;
+        Counters counters_;
+        LatencyHistogram round_trips_;
+        int64_t elapsed_ns_ = 0;
+    };
+}
+
+int main(int argc, char** argv) {
+    Options options(argc, argv);
+    const std::string transport = options.String("--transport", "loopback");
+    if (transport != "loopback" && transport != "tcp") {
+        printf("Unknown transport '%s': expected loopback or tcp\n", transport.c_str());
+        return 2;
+    }
+
+    MockEffectRuntime::Latencies latencies;
+    latencies.set_state_ns = (int64_t)(options.Double("--apply-us", 0.0) * 1000);
+    BenchHost host((int)std::max<int64_t>(options.Int("--techniques", 64), 1), options.Double("--fps", 144.0), latencies,
+        transport == "tcp" ? TransportKind::Platform : TransportKind::Loopback, (int)options.Int("--port", BENCH_PORT));
+    if (!host.Opened()) {
+        printf("Could not open the server\n");
+        return 1;
+    }
+    host.CommandServer().SetRateLimit(options.Double("--rate-limit", 0.0), options.Double("--burst", 0.0));
+
+    LoadGenerator generator(host, options);
+    generator.Run((int64_t)(options.Double("--duration", 5.0) * 1e9));
+    host.Settle();
+
+    generator.Report();
+    printf("Server and engine\n");
+    printf("  %-28s %llu\n", "rate limited", (unsigned long long)host.CommandServer().CommandsRateLimited());
+    printf("  %-28s %d\n", "engine queue drops", host.Commands().CommandsDropped());
+    printf("  %-28s %d\n", "applied", host.Commands().CommandsApplied());
+    printf("  %-28s %d\n", "coalesced", host.Commands().CommandsCoalesced());
+    PrintLatency("receive -> on screen", host.Commands().Latency(LatencyStage::Total).Summarize());
+    return generator.Healthy() ? 0 : 1;
+}
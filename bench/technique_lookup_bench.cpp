@@ -0,0 +1,92 @@
+// Technique name lookups on a large effect set: TechniqueCatalog's hash and trigram indexes
+// next to the linear name_lower.find() scan every partial match used before them.
+//
+//   technique_lookup_bench [--techniques 5000] [--lookups 200000]
+#include "bench_host.hpp"
+#include "technique_catalog.hpp"
+#include <algorithm>
+#include <vector>
+
+using namespace streamerbot;
+using namespace streamerbot::bench;
+
+namespace {
+    const char* const EFFECT_NAMES[] = { "Bloom", "MotionBlur", "Vignette", "Sharpen", "ColorGrade", "Chromatic",
+        "FilmGrain", "DepthOfField", "Outline", "Pixelate", "CRT", "Glitch" };
+
+    // Every partial match by scanning the folded names, as lookups did before the trigram index
+    size_t LinearMatches(const TechniqueCatalog& catalog, std::string_view query_lower) {
+        size_t matches = 0;
+        for (size_t i = 0; i < catalog.Size(); ++i) {
+            if (std::string_view(catalog[i].name_lower).find(query_lower) != std::string_view::npos) ++matches;
+        }
+        return matches;
+    }
+
+    std::string Lower(std::string text) {
+        std::transform(text.begin(), text.end(), text.begin(), FoldAscii);
+        return text;
+    }
+
+    template <typename Lookup>
+    void Measure(const char* label, const std::vector<std::string>& queries, int64_t lookups, Lookup&& lookup) {
+        size_t matches = 0;
+        const int64_t start = MonotonicNs();
+        for (int64_t i = 0; i < lookups; ++i) {
+            matches += lookup(queries[i % queries.size()]);
+        }
+        const double elapsed_ns = (double)(MonotonicNs() - start);
+        printf("  %-34s %10.1f ns/lookup  (%zu matches)\n", label, elapsed_ns / lookups, matches);
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options(argc, argv);
+    const int techniques = (int)std::max<int64_t>(options.Int("--techniques", 5000), 1);
+    const int64_t lookups = std::max<int64_t>(options.Int("--lookups", 200000), 1);
+
+    MockEffectRuntime runtime;
+    std::vector<std::string> names;
+    for (int i = 0; i < techniques; ++i) {
+        names.push_back(std::string(EFFECT_NAMES[i % std::size(EFFECT_NAMES)]) + "_Pass" + std::to_string(i));
+        runtime.AddTechnique(names.back());
+    }
+    TechniqueCatalog catalog;
+    catalog.Rebuild(runtime);
+
+    // Exact names, the same names in another case, a few partial names that repeat like chat
+    // commands do, and more distinct partial names than the match cache holds
+    std::vector<std::string> exact, folded, repeated, distinct;
+    for (int i = 0; i < 256; ++i) {
+        exact.push_back(names[(i * 7919) % names.size()]);
+        folded.push_back(Lower(exact.back()));
+    }
+    for (const char* effect : EFFECT_NAMES) {
+        repeated.push_back(Lower(effect).substr(0, 5));
+    }
+    for (size_t i = 0; i < MATCH_CACHE_CAPACITY * 4; ++i) {
+        distinct.push_back("pass" + std::to_string(i % techniques) + (i < MATCH_CACHE_CAPACITY * 2 ? "" : "9"));
+    }
+
+    printf("%d techniques, %lld lookups per case\n", techniques, (long long)lookups);
+    auto indexed = [&catalog](const std::string& query) { return catalog.ForEachMatch(query, [](const TechniqueCatalog::Entry&) {}); };
+    auto linear = [&catalog](const std::string& query) { return LinearMatches(catalog, Lower(query)); };
+
+    Measure("exact name, index", exact, lookups, indexed);
+    Measure("other case, index", folded, lookups, indexed);
+    Measure("repeated partial name, index", repeated, lookups, indexed);
+    Measure("repeated partial name, linear", repeated, lookups / 100 + 1, linear);
+    Measure("distinct partial names, index", distinct, lookups / 10 + 1, indexed);
+    Measure("distinct partial names, linear", distinct, lookups / 100 + 1, linear);
+
+    // Both paths must find the same techniques
+    for (const std::vector<std::string>* queries : { &repeated, &distinct }) {
+        for (const std::string& query : *queries) {
+            if (indexed(query) != linear(query)) {
+                printf("FAILED: '%s' matched differently\n", query.c_str());
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,110 @@
+// WebSocket command throughput over the loopback transport (or TCP). Each client upgrades,
+// then keeps --window masked text frames in flight and counts the text frames that come back.
+//
+//   websocket_throughput_bench [--clients 4] [--messages 20000] [--window 16] [--lines 1]
+//                              [--transport loopback|tcp] [--port 7777]
+//
+// --lines puts that many commands in each message, as a client batching chat commands would.
+#include "bench_host.hpp"
+#include "websocket_client.hpp"
+#include <vector>
+
+using namespace streamerbot;
+using namespace streamerbot::bench;
+
+namespace {
+    constexpr int TECHNIQUES = 32;
+
+    struct ClientResult {
+        uint64_t replies = 0;
+        uint64_t busy = 0;      // "ERROR busy": the engine queue was full
+        bool ok = true;
+    };
+
+    void RunClient(BenchHost& host, int index, int messages, int window, int lines, LatencyHistogram& round_trips, ClientResult& result) {
+        test::WebSocketClient client(host.Transport(), host.Connect());
+        if (!client.Upgrade()) {
+            result.ok = false;
+            return;
+        }
+
+        std::string message;
+        for (int line = 0; line < lines; ++line) {
+            if (line > 0) message += '\n';
+            message += "TOGGLE Technique" + std::to_string((index * 5 + line) % TECHNIQUES);
+        }
+
+        std::vector<int64_t> sent_ns(messages);
+        int sent = 0;
+        uint64_t replies = 0;
+        const uint64_t expected = (uint64_t)messages * lines;
+        uint8_t opcode;
+        std::string payload;
+        while (replies < expected) {
+            while (sent < messages && sent * (uint64_t)lines - replies < (uint64_t)window * lines) {
+                sent_ns[sent] = MonotonicNs();
+                if (!client.SendText(message)) {
+                    result.ok = false;
+                    return;
+                }
+                ++sent;
+            }
+            if (!client.ReadFrame(opcode, payload, 60000) || opcode != websocket::OP_TEXT) {
+                result.ok = false;
+                break;
+            }
+            if (payload == "ERROR busy") result.busy++;
+            else if (payload != "OK") result.ok = false;
+            // The last reply to a message completes it
+            if (++replies % lines == 0) round_trips.Record(MonotonicNs() - sent_ns[replies / lines - 1]);
+        }
+        result.replies = replies;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options(argc, argv);
+    const int clients = (int)std::max<int64_t>(options.Int("--clients", 4), 1);
+    const int messages = (int)std::max<int64_t>(options.Int("--messages", 20000) / clients, 1);
+    const int window = (int)std::max<int64_t>(options.Int("--window", 16), 1);
+    const int lines = (int)std::max<int64_t>(options.Int("--lines", 1), 1);
+    const std::string transport = options.String("--transport", "loopback");
+
+    BenchHost host(TECHNIQUES, 144.0, {}, transport == "tcp" ? TransportKind::Platform : TransportKind::Loopback,
+        (int)options.Int("--port", BENCH_PORT));
+    if (!host.Opened()) {
+        printf("Could not open the server\n");
+        return 1;
+    }
+    // Measure the server, not the per-frame apply budget
+    host.Commands().SetLowPriorityBudget(1 << 20);
+
+    printf("%d WebSocket clients x %d messages of %d command(s), %d in flight, %s\n", clients, messages, lines, window, transport.c_str());
+    LatencyHistogram round_trips;
+    std::vector<ClientResult> results(clients);
+    std::vector<std::thread> threads;
+    const int64_t start = MonotonicNs();
+    for (int i = 0; i < clients; ++i) {
+        threads.emplace_back(RunClient, std::ref(host), i, messages, window, lines, std::ref(round_trips), std::ref(results[i]));
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    const double seconds = (MonotonicNs() - start) / 1e9;
+
+    uint64_t replies = 0, busy = 0;
+    bool ok = true;
+    for (const ClientResult& result : results) {
+        replies += result.replies;
+        busy += result.busy;
+        ok = ok && result.ok;
+    }
+    printf("  %-28s %.0f messages/s, %.0f replies/s\n", "throughput", replies / lines / seconds, replies / seconds);
+    printf("  %-28s %llu\n", "dropped: engine busy", (unsigned long long)busy);
+    PrintLatency("message -> last reply", round_trips.Summarize());
+    if (!ok) {
+        printf("FAILED: a client lost its connection or got an unexpected reply\n");
+        return 1;
+    }
+    return 0;
+}
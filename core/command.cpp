@@ -0,0 +1,405 @@
+#include "command.hpp"
+#include "text.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+namespace streamerbot {
+
+    namespace {
+        // Command keywords, matched case-insensitively through a perfect hash that is built and
+        // checked at compile time
+        struct CommandKeyword {
+            std::string_view name;
+            CommandAction action;
+        };
+
+        constexpr CommandKeyword COMMAND_KEYWORDS[] = {
+            { "TOGGLE", CommandAction::Toggle },
+            { "ENABLE", CommandAction::Enable },
+            { "ON", CommandAction::Enable },
+            { "DISABLE", CommandAction::Disable },
+            { "OFF", CommandAction::Disable },
+            { "SET", CommandAction::Set },
+            { "GET", CommandAction::Get },
+            { "TWEEN", CommandAction::Tween },
+            { "DEBOUNCE", CommandAction::Debounce },
+            { "BEGIN", CommandAction::BatchBegin },
+            { "COMMIT", CommandAction::BatchCommit },
+            { "ABORT", CommandAction::BatchAbort },
+        };
+        constexpr size_t KEYWORD_COUNT = sizeof(COMMAND_KEYWORDS) / sizeof(COMMAND_KEYWORDS[0]);
+        constexpr size_t KEYWORD_TABLE_SIZE = 32;
+
+        constexpr size_t KeywordSlot(std::string_view word) {
+            return (word.size() * 7 + (uint8_t)FoldAscii(word.front()) * 5 + (uint8_t)FoldAscii(word.back()) * 2) % KEYWORD_TABLE_SIZE;
+        }
+
+        struct KeywordTable {
+            int8_t slots[KEYWORD_TABLE_SIZE];
+            bool perfect;
+        };
+
+        constexpr KeywordTable BuildKeywordTable() {
+            KeywordTable table = {};
+            for (size_t i = 0; i < KEYWORD_TABLE_SIZE; ++i) {
+                table.slots[i] = -1;
+            }
+            table.perfect = true;
+            for (size_t i = 0; i < KEYWORD_COUNT; ++i) {
+                size_t slot = KeywordSlot(COMMAND_KEYWORDS[i].name);
+                if (table.slots[slot] != -1) table.perfect = false;
+                table.slots[slot] = (int8_t)i;
+            }
+            return table;
+        }
+
+        constexpr KeywordTable KEYWORD_TABLE = BuildKeywordTable();
+        static_assert(KEYWORD_TABLE.perfect, "command keywords collide in KeywordSlot(); adjust the hash");
+
+        // Maps an action word to its keyword entry with one table probe and one compare
+        const CommandKeyword* LookupKeyword(std::string_view word) {
+            if (word.empty()) return nullptr;
+            int8_t index = KEYWORD_TABLE.slots[KeywordSlot(word)];
+            if (index < 0 || !EqualsIgnoreCase(COMMAND_KEYWORDS[index].name, word)) return nullptr;
+            return &COMMAND_KEYWORDS[index];
+        }
+
+        struct EasingName {
+            std::string_view name;
+            TweenEasing easing;
+        };
+
+        constexpr EasingName EASING_NAMES[] = {
+            { "linear", TweenEasing::Linear },
+            { "easeIn", TweenEasing::EaseIn },
+            { "easeOut", TweenEasing::EaseOut },
+            { "easeInOut", TweenEasing::EaseInOut },
+            { "easeInCubic", TweenEasing::EaseInCubic },
+            { "easeOutCubic", TweenEasing::EaseOutCubic },
+        };
+
+        // Takes the next token from rest, skipping leading separators
+        std::string_view NextToken(std::string_view& rest, std::string_view separators = " \t") {
+            size_t start = rest.find_first_not_of(separators);
+            if (start == std::string_view::npos) {
+                rest = std::string_view();
+                return std::string_view();
+            }
+            rest = rest.substr(start);
+            size_t end = rest.find_first_of(separators);
+            std::string_view token = rest.substr(0, end);
+            rest = (end == std::string_view::npos) ? std::string_view() : rest.substr(end);
+            return token;
+        }
+
+        // Parses one SET value: a number, or true/false/on/off. Locale independent.
+        bool ParseValue(std::string_view token, double& value) {
+            if (EqualsIgnoreCase(token, "true") || EqualsIgnoreCase(token, "on")) {
+                value = 1.0;
+                return true;
+            }
+            if (EqualsIgnoreCase(token, "false") || EqualsIgnoreCase(token, "off")) {
+                value = 0.0;
+                return true;
+            }
+            if (!token.empty() && token.front() == '+') token.remove_prefix(1);
+            auto parsed = std::from_chars(token.data(), token.data() + token.size(), value);
+            return parsed.ec == std::errc() && parsed.ptr == token.data() + token.size();
+        }
+
+        // Parses "2000ms", "1.5s" or a plain number of milliseconds
+        bool ParseDuration(std::string_view token, int64_t& duration_ns) {
+            double scale = 1e6;
+            if (token.size() > 2 && EqualsIgnoreCase(token.substr(token.size() - 2), "ms")) {
+                token.remove_suffix(2);
+            }
+            else if (token.size() > 1 && FoldAscii(token.back()) == 's') {
+                token.remove_suffix(1);
+                scale = 1e9;
+            }
+
+            double amount = 0.0;
+            auto parsed = std::from_chars(token.data(), token.data() + token.size(), amount);
+            if (parsed.ec != std::errc() || parsed.ptr != token.data() + token.size()) return false;
+            if (!(amount > 0.0 && amount * scale < 9e18)) return false;
+            duration_ns = std::max<int64_t>((int64_t)(amount * scale), 1);
+            return true;
+        }
+
+        // Parses values from rest into out.values, starting at out.value_count, until rest
+        // ends or a token fails to parse
+        CommandResult ParseValues(std::string_view rest, std::string_view separators, PendingCommand& out) {
+            for (std::string_view token = NextToken(rest, separators); !token.empty(); token = NextToken(rest, separators)) {
+                if (out.value_count == MAX_UNIFORM_VALUES) {
+                    return CommandResult::TooManyValues;
+                }
+                if (!ParseValue(token, out.values[out.value_count])) {
+                    return CommandResult::InvalidValue;
+                }
+                out.value_count++;
+            }
+            return CommandResult::Queued;
+        }
+
+        // Splits "<target> <value> <value>..." for SET; values may also be comma-separated
+        CommandResult ParseSetArguments(std::string_view arguments, PendingCommand& out, std::string_view& target) {
+            target = NextToken(arguments);
+            out.value_count = 0;
+            CommandResult result = ParseValues(arguments, " \t,", out);
+            if (result != CommandResult::Queued) return result;
+            return out.value_count ? CommandResult::Queued : CommandResult::MissingValue;
+        }
+
+        // Splits "<target> <from> <to> <duration> [easing]" for TWEEN. from and to are a single
+        // value or comma-separated components; a single value applies to every component.
+        CommandResult ParseTweenArguments(std::string_view arguments, PendingCommand& out, std::string_view& target) {
+            target = NextToken(arguments);
+            std::string_view from = NextToken(arguments);
+            std::string_view to = NextToken(arguments);
+            std::string_view duration = NextToken(arguments);
+            std::string_view easing = NextToken(arguments);
+            if (duration.empty()) {
+                return CommandResult::MissingValue;
+            }
+            if (!NextToken(arguments).empty()) {
+                return CommandResult::TooManyValues;
+            }
+
+            out.value_count = 0;
+            CommandResult result = ParseValues(from, ",", out);
+            if (result != CommandResult::Queued) return result;
+            out.from_count = out.value_count;
+            result = ParseValues(to, ",", out);
+            if (result != CommandResult::Queued) return result;
+
+            const size_t to_count = out.value_count - out.from_count;
+            if (out.from_count != to_count && out.from_count != 1 && to_count != 1) {
+                return CommandResult::InvalidValue;
+            }
+
+            if (!ParseDuration(duration, out.duration_ns)) {
+                return CommandResult::InvalidDuration;
+            }
+
+            out.easing = TweenEasing::Linear;
+            if (!easing.empty()) {
+                const EasingName* match = std::find_if(std::begin(EASING_NAMES), std::end(EASING_NAMES),
+                    [easing](const EasingName& name) { return EqualsIgnoreCase(name.name, easing); });
+                if (match == std::end(EASING_NAMES)) {
+                    return CommandResult::UnknownEasing;
+                }
+                out.easing = match->easing;
+            }
+            return CommandResult::Queued;
+        }
+
+        // Splits a trailing "FOR <duration>" off a technique target: ENABLE X FOR 30s
+        CommandResult ParseLease(CommandAction action, std::string_view& target, PendingCommand& out) {
+            size_t duration_start = target.find_last_of(" \t");
+            if (duration_start == std::string_view::npos) return CommandResult::Queued;
+            std::string_view head = Trim(target.substr(0, duration_start));
+            size_t for_start = head.find_last_of(" \t");
+            std::string_view word = (for_start == std::string_view::npos) ? head : head.substr(for_start + 1);
+            if (!EqualsIgnoreCase(word, "FOR")) return CommandResult::Queued;
+
+            if (action != CommandAction::Enable) {
+                return CommandResult::LeaseNeedsEnable;
+            }
+            if (!ParseDuration(target.substr(duration_start + 1), out.duration_ns)) {
+                return CommandResult::InvalidDuration;
+            }
+            target = (for_start == std::string_view::npos) ? std::string_view() : Trim(head.substr(0, for_start));
+            return target.empty() ? CommandResult::MissingTarget : CommandResult::Queued;
+        }
+
+        // Splits "<target> <duration>" for DEBOUNCE; "off" or 0 removes the window
+        CommandResult ParseDebounceArguments(std::string_view arguments, PendingCommand& out, std::string_view& target) {
+            size_t duration_start = arguments.find_last_of(" \t");
+            if (duration_start == std::string_view::npos) {
+                return CommandResult::MissingValue;
+            }
+            std::string_view duration = arguments.substr(duration_start + 1);
+            target = Trim(arguments.substr(0, duration_start));
+            if (EqualsIgnoreCase(duration, "off") || duration == "0") {
+                out.duration_ns = 0;
+                return CommandResult::Queued;
+            }
+            return ParseDuration(duration, out.duration_ns) ? CommandResult::Queued : CommandResult::InvalidDuration;
+        }
+
+        // "frame+N <command>" or "t+<duration> <command>": parses the command and records when
+        // it should run, relative to its arrival. frame+1 is the next frame.
+        CommandResult ParseScheduled(std::string_view arguments, PendingCommand& out) {
+            std::string_view when = NextToken(arguments);
+            std::string_view command = Trim(arguments);
+            uint64_t at_frame = 0;
+            int64_t at_ns = 0;
+            if (when.size() > 6 && EqualsIgnoreCase(when.substr(0, 6), "frame+")) {
+                uint32_t frames = 0;
+                auto parsed = std::from_chars(when.data() + 6, when.data() + when.size(), frames);
+                if (parsed.ec != std::errc() || parsed.ptr != when.data() + when.size() || frames > MAX_SCHEDULE_FRAMES) {
+                    return CommandResult::InvalidSchedule;
+                }
+                at_frame = frames;
+            }
+            else if (when.size() > 2 && EqualsIgnoreCase(when.substr(0, 2), "t+")) {
+                if (!ParseDuration(when.substr(2), at_ns) || at_ns > MAX_SCHEDULE_NS) {
+                    return CommandResult::InvalidSchedule;
+                }
+            }
+            else {
+                return CommandResult::InvalidSchedule;
+            }
+
+            if (command.empty()) {
+                return CommandResult::InvalidSchedule;
+            }
+            CommandResult result = ParseCommand(command, out);
+            if (result != CommandResult::Queued && result != CommandResult::ReplyPending) {
+                return result;
+            }
+
+            // Checked on the parsed command, so a PRIORITY prefix cannot hide a second AT or
+            // batch control
+            if (out.at_frame != 0 || out.at_ns != 0 || out.action == CommandAction::BatchBegin ||
+                out.action == CommandAction::BatchCommit || out.action == CommandAction::BatchAbort) {
+                return CommandResult::InvalidSchedule;
+            }
+            out.at_frame = at_frame;
+            out.at_ns = at_ns;
+            return result;
+        }
+
+        // Whether a command starts with a PRIORITY prefix, possibly behind AT prefixes
+        bool HasPriorityPrefix(std::string_view command) {
+            while (true) {
+                std::string_view action = NextToken(command);
+                if (EqualsIgnoreCase(action, "PRIORITY")) {
+                    return true;
+                }
+                if (!EqualsIgnoreCase(action, "AT")) {
+                    return false;
+                }
+                NextToken(command);
+            }
+        }
+
+        // "HIGH <command>" or "LOW <command>": parses the command into the given lane
+        CommandResult ParsePriority(std::string_view arguments, PendingCommand& out) {
+            std::string_view lane = NextToken(arguments);
+            std::string_view command = Trim(arguments);
+            if (EqualsIgnoreCase(lane, "HIGH")) {
+                out.priority = CommandPriority::High;
+            }
+            else if (EqualsIgnoreCase(lane, "LOW")) {
+                out.priority = CommandPriority::Low;
+            }
+            else {
+                return CommandResult::InvalidPriority;
+            }
+            if (command.empty()) {
+                return CommandResult::UnknownAction;
+            }
+            if (HasPriorityPrefix(command)) {
+                return CommandResult::InvalidPriority;
+            }
+            CommandResult result = ParseCommand(command, out);
+            if (result != CommandResult::Queued && result != CommandResult::ReplyPending) {
+                return result;
+            }
+
+            // Batch control takes the connection's batch, not a lane
+            if (out.action == CommandAction::BatchBegin || out.action == CommandAction::BatchCommit ||
+                out.action == CommandAction::BatchAbort) {
+                return CommandResult::InvalidPriority;
+            }
+            return result;
+        }
+    }
+
+    CommandResult ParseCommand(std::string_view line, PendingCommand& out) {
+        line = Trim(line);
+        size_t split = line.find_first_of(" \t");
+        std::string_view action = line.substr(0, split);
+        std::string_view target = (split == std::string_view::npos) ? std::string_view() : Trim(line.substr(split));
+
+        if (EqualsIgnoreCase(action, "AT")) {
+            return ParseScheduled(target, out);
+        }
+        if (EqualsIgnoreCase(action, "PRIORITY")) {
+            return ParsePriority(target, out);
+        }
+
+        const CommandKeyword* keyword = LookupKeyword(action);
+        if (!keyword) {
+            return CommandResult::UnknownAction;
+        }
+        switch (keyword->action) {
+        case CommandAction::BatchBegin:
+        case CommandAction::BatchCommit:
+        case CommandAction::BatchAbort:
+            out.action = keyword->action;
+            out.target_length = 0;
+            return CommandResult::Queued;
+        default:
+            break;
+        }
+        if (target.empty()) {
+            return CommandResult::MissingTarget;
+        }
+        if (keyword->action == CommandAction::Set || keyword->action == CommandAction::Tween) {
+            CommandResult values = keyword->action == CommandAction::Set
+                ? ParseSetArguments(target, out, target)
+                : ParseTweenArguments(target, out, target);
+            if (values != CommandResult::Queued) {
+                return values;
+            }
+        }
+        else if (keyword->action == CommandAction::Debounce) {
+            CommandResult debounce = ParseDebounceArguments(target, out, target);
+            if (debounce != CommandResult::Queued) {
+                return debounce;
+            }
+        }
+        else if (keyword->action != CommandAction::Get) {
+            CommandResult lease = ParseLease(keyword->action, target, out);
+            if (lease != CommandResult::Queued) {
+                return lease;
+            }
+        }
+        if (target.size() >= MAX_TARGET_LENGTH) {
+            return CommandResult::TargetTooLong;
+        }
+
+        out.action = keyword->action;
+        out.target_length = (uint16_t)target.size();
+        memcpy(out.target, target.data(), target.size());
+        return keyword->action == CommandAction::Get ? CommandResult::ReplyPending : CommandResult::Queued;
+    }
+
+    const char* CommandResultReply(CommandResult result) {
+        switch (result) {
+        case CommandResult::Queued: return "OK";
+        case CommandResult::ReplyPending: return "OK";
+        case CommandResult::Staged: return "OK";
+        case CommandResult::NoBatch: return "ERROR no batch open";
+        case CommandResult::BatchTooLarge: return "ERROR batch too large";
+        case CommandResult::MissingValue: return "ERROR no value specified";
+        case CommandResult::InvalidValue: return "ERROR invalid value";
+        case CommandResult::TooManyValues: return "ERROR too many values";
+        case CommandResult::InvalidDuration: return "ERROR invalid duration";
+        case CommandResult::UnknownEasing: return "ERROR unknown easing";
+        case CommandResult::LeaseNeedsEnable: return "ERROR FOR only applies to ENABLE";
+        case CommandResult::InvalidSchedule: return "ERROR invalid schedule";
+        case CommandResult::InvalidPriority: return "ERROR invalid priority";
+        case CommandResult::NoRuntime: return "ERROR no runtime";
+        case CommandResult::MissingTarget: return "ERROR no technique specified";
+        case CommandResult::TargetTooLong: return "ERROR technique name too long";
+        case CommandResult::UnknownAction: return "ERROR unknown action";
+        case CommandResult::QueueFull: return "ERROR busy";
+        }
+        return "ERROR";
+    }
+
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include "tween_engine.hpp"
+#include "uniform_catalog.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace streamerbot {
+
+    constexpr size_t MAX_TARGET_LENGTH = 256;
+    constexpr size_t MAX_REPLY_LENGTH = 512;
+    constexpr size_t MAX_BATCH_COMMANDS = 64;       // Commands in one BEGIN/COMMIT or ';' batch
+    constexpr uint32_t MAX_SCHEDULE_FRAMES = 1u << 24;              // Furthest AT frame+N
+    constexpr int64_t MAX_SCHEDULE_NS = 24ll * 3600 * 1000000000;   // Furthest AT t+<duration>
+
+    enum class CommandAction : uint8_t {
+        Toggle,
+        Enable,
+        Disable,
+        Set,        // Write a uniform variable
+        Get,        // Read a uniform variable; answered from the render thread
+        Tween,      // Animate a uniform variable
+        Debounce,   // Set a technique's minimum time between state changes
+        BatchBegin,     // Stage the following commands on this connection
+        BatchCommit,    // Queue the staged commands to be applied in one frame
+        BatchAbort,     // Discard the staged commands
+    };
+
+    // Lanes between the network and render threads. Every frame the render thread empties the
+    // high lane first, then runs the low lane under a per-frame budget.
+    enum class CommandPriority : uint8_t {
+        High,       // Operator and producer commands
+        Low,        // Audience commands
+    };
+    constexpr size_t COMMAND_PRIORITY_COUNT = 2;
+
+    // Parsed command handed from the network thread to the render thread
+    struct PendingCommand {
+        CommandAction action = CommandAction::Toggle;
+        uint16_t target_length = 0;
+        char target[MAX_TARGET_LENGTH] = {};
+        int64_t received_ns = 0;    // MonotonicNs() when the line arrived
+        int64_t enqueued_ns = 0;    // MonotonicNs() when it was queued
+        uint32_t client_id = 0;     // Connection to send render-thread replies to; 0 for none
+        uint8_t value_count = 0;
+        double values[MAX_UNIFORM_VALUES] = {};     // SET values, converted to the uniform's type when applied
+        uint8_t from_count = 0;     // TWEEN: values[0, from_count) are the start values, the rest the end values
+        TweenEasing easing = TweenEasing::Linear;
+        int64_t duration_ns = 0;    // TWEEN duration; for ENABLE, how long the lease holds (0 for none); DEBOUNCE window
+        uint16_t batch_remaining = 0;   // Commands of the same batch queued right behind this one
+        CommandPriority priority = CommandPriority::Low;    // The connection's lane unless a PRIORITY prefix chose one
+        uint64_t at_frame = 0;      // AT frame+N: first frame to apply on (0 for none); relative to the arrival frame until submitted
+        int64_t at_ns = 0;          // AT t+<duration>: earliest MonotonicNs() to apply at (0 for none); relative until submitted
+
+        std::string_view Target() const { return std::string_view(target, target_length); }
+    };
+
+    // Reply produced on the render thread, routed back to the connection the command came from
+    struct CommandReply {
+        uint32_t client_id = 0;
+        uint16_t length = 0;
+        char text[MAX_REPLY_LENGTH] = {};
+
+        std::string_view Text() const { return std::string_view(text, length); }
+    };
+
+    // Outcome of handing a command line to the command engine, reported back to the client
+    enum class CommandResult {
+        Queued,
+        ReplyPending,       // Queued; the render thread sends the reply
+        Staged,             // Added to the connection's open batch; acknowledged at COMMIT
+        NoBatch,
+        BatchTooLarge,
+        MissingValue,
+        InvalidValue,
+        TooManyValues,
+        InvalidDuration,
+        UnknownEasing,
+        LeaseNeedsEnable,
+        InvalidSchedule,
+        InvalidPriority,
+        NoRuntime,
+        MissingTarget,
+        TargetTooLong,
+        UnknownAction,
+        QueueFull,
+    };
+
+    // Tokenizes a command line in place. FORMAT: "<ACTION> <technique_name>",
+    // "ENABLE <technique_name> FOR <duration>", "DEBOUNCE <technique_name> <duration|off>",
+    // "SET <Effect.fx/Variable> <value>...", "GET <Effect.fx/Variable>" or
+    // "TWEEN <Effect.fx/Variable> <from> <to> <duration> [easing]", optionally prefixed with
+    // "AT frame+N", "AT t+<duration>" or "PRIORITY HIGH|LOW". The result holds its own copy
+    // of the target name, so parsing never allocates. out.priority is only written by a
+    // PRIORITY prefix, so set the default lane before parsing.
+    CommandResult ParseCommand(std::string_view line, PendingCommand& out);
+
+    const char* CommandResultReply(CommandResult result);
+
+}
@@ -0,0 +1,635 @@
+#include "command_engine.hpp"
+#include "text.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace streamerbot {
+
+    namespace {
+        // Reads a uniform and appends its values to out as space-separated text
+        template <typename T>
+        void FormatUniform(EffectRuntime& runtime, UniformHandle variable, size_t count, char*& out, char* end) {
+            T values[MAX_UNIFORM_VALUES];
+            runtime.GetUniformValues(variable, values, count);
+            for (size_t i = 0; i < count && out < end; ++i) {
+                *out++ = ' ';
+                if constexpr (std::is_same_v<T, bool>) {
+                    const std::string_view text = values[i] ? "true" : "false";
+                    const size_t length = std::min(text.size(), (size_t)(end - out));
+                    memcpy(out, text.data(), length);
+                    out += length;
+                }
+                else {
+                    out = std::to_chars(out, end, values[i]).ptr;
+                }
+            }
+        }
+    }
+
+    CommandResult CommandEngine::Submit(std::string_view command, int64_t received_ns, CommandSource& source) {
+        if (!runtime_available_.load(std::memory_order_acquire)) {
+            log_.Write("Error: No runtime available", LogColor{ 1.0f, 0.0f, 0.0f, 1.0f });
+            return CommandResult::NoRuntime;
+        }
+
+        if (command.find(';') == std::string_view::npos) {
+            return SubmitOne(command, received_ns, source);
+        }
+
+        // "A; B; C" is an implicit BEGIN/COMMIT, unless it extends a batch that is already open
+        const bool implicit_batch = !source.batch_open;
+        if (implicit_batch) {
+            source.batch_open = true;
+            source.batch_error = CommandResult::Queued;
+            source.batch.clear();
+        }
+
+        CommandResult result = CommandResult::Staged;
+        while (!command.empty()) {
+            size_t split = command.find(';');
+            std::string_view part = Trim(command.substr(0, split));
+            command = (split == std::string_view::npos) ? std::string_view() : command.substr(split + 1);
+            if (part.empty()) continue;
+
+            CommandResult part_result = SubmitOne(part, received_ns, source);
+            if (part_result != CommandResult::Staged) {
+                result = part_result;
+            }
+        }
+
+        if (implicit_batch && source.batch_open) {
+            source.batch_open = false;
+            result = CommitBatch(source);
+        }
+        return result;
+    }
+
+    CommandResult CommandEngine::SubmitOne(std::string_view command, int64_t received_ns, CommandSource& source) {
+        commands_received_++;
+
+        PendingCommand pending;
+        pending.priority = source.priority;
+        CommandResult result = ParseCommand(command, pending);
+        const int64_t parsed_ns = MonotonicNs();
+        if (result != CommandResult::Queued && result != CommandResult::ReplyPending) {
+            parse_errors_++;
+            LogParseError(result, command);
+            if (source.batch_open) {
+                if (source.batch_error == CommandResult::Queued) source.batch_error = result;
+                return CommandResult::Staged;
+            }
+            return result;
+        }
+
+        RecordLatency(LatencyStage::Parse, parsed_ns - received_ns);
+
+        switch (pending.action) {
+        case CommandAction::BatchBegin:
+            if (source.batch_open) {
+                // A nested BEGIN keeps staging into the open batch
+                return CommandResult::Staged;
+            }
+            source.batch_open = true;
+            source.batch_error = CommandResult::Queued;
+            source.batch.clear();
+            return CommandResult::Staged;
+        case CommandAction::BatchCommit:
+            if (!source.batch_open) return CommandResult::NoBatch;
+            source.batch_open = false;
+            return CommitBatch(source);
+        case CommandAction::BatchAbort:
+            if (!source.batch_open) return CommandResult::NoBatch;
+            source.batch_open = false;
+            source.batch.clear();
+            log_.Write("Batch aborted", LogColor{ 1.0f, 0.5f, 0.0f, 1.0f });
+            return CommandResult::Queued;
+        default:
+            break;
+        }
+
+        pending.client_id = source.client_id;
+        pending.received_ns = received_ns;
+        // AT offsets count from the frame and time the line arrived
+        if (pending.at_frame > 0) pending.at_frame += frames_.Frame();
+        if (pending.at_ns > 0) pending.at_ns += received_ns;
+
+        if (source.batch_open) {
+            // A batch applies in one frame; an AT command inside it would split it
+            if (pending.at_frame > 0 || pending.at_ns > 0) {
+                if (source.batch_error == CommandResult::Queued) source.batch_error = CommandResult::InvalidSchedule;
+                return CommandResult::Staged;
+            }
+            if (source.batch.size() >= MAX_BATCH_COMMANDS) {
+                if (source.batch_error == CommandResult::Queued) source.batch_error = CommandResult::BatchTooLarge;
+                return CommandResult::Staged;
+            }
+            source.batch.push_back(pending);
+            return CommandResult::Staged;
+        }
+
+        CommandResult queued = Enqueue(&pending, 1);
+        return queued == CommandResult::Queued ? result : queued;
+    }
+
+    // Queues the staged batch as one unit, or rejects all of it
+    CommandResult CommandEngine::CommitBatch(CommandSource& source) {
+        CommandResult result = source.batch_error;
+        if (result == CommandResult::BatchTooLarge) {
+            log_.Write("Batch rejected: more than " + std::to_string(MAX_BATCH_COMMANDS) + " commands", LogColor{ 1.0f, 0.5f, 0.0f, 1.0f });
+        }
+        else if (result != CommandResult::Queued) {
+            log_.Write("Batch rejected: " + std::string(CommandResultReply(result)), LogColor{ 1.0f, 0.5f, 0.0f, 1.0f });
+        }
+        else {
+            result = Enqueue(source.batch.data(), source.batch.size());
+        }
+        source.batch.clear();
+        return result;
+    }
+
+    // Queues commands in consecutive slots; a batch is only ever queued whole, in the highest
+    // lane any of its commands asked for
+    CommandResult CommandEngine::Enqueue(PendingCommand* commands, size_t count) {
+        if (count == 0) return CommandResult::Queued;
+
+        CommandPriority priority = CommandPriority::Low;
+        for (size_t i = 0; i < count; ++i) {
+            priority = std::min(priority, commands[i].priority);
+        }
+        auto& queue = queues_[(size_t)priority];
+
+        const int64_t start_ns = MonotonicNs();
+        for (size_t i = 0; i < count; ++i) {
+            commands[i].enqueued_ns = start_ns;
+            commands[i].batch_remaining = (uint16_t)(count - 1 - i);
+        }
+
+        bool queued = count == 1 ? queue.TryPush(commands[0]) : queue.TryPushBatch(commands, count);
+        if (!queued) {
+            commands_dropped_ += (int)count;
+            if (count == 1) {
+                log_.Write("Command queue full, dropped: " + std::string(commands[0].Target()), LogColor{ 1.0f, 0.0f, 0.0f, 1.0f });
+            }
+            else {
+                log_.Write("Command queue full, dropped batch of " + std::to_string(count), LogColor{ 1.0f, 0.0f, 0.0f, 1.0f });
+            }
+            return CommandResult::QueueFull;
+        }
+
+        const int64_t enqueue_ns = MonotonicNs() - start_ns;
+        for (size_t i = 0; i < count; ++i) {
+            RecordLatency(LatencyStage::Enqueue, enqueue_ns);
+        }
+        if (count > 1) {
+            log_.Write("Batch queued: " + std::to_string(count) + " commands", LogColor{ 0.7f, 0.7f, 1.0f, 1.0f });
+        }
+        return CommandResult::Queued;
+    }
+
+    void CommandEngine::LogParseError(CommandResult result, std::string_view command) {
+        switch (result) {
+        case CommandResult::UnknownAction:
+            log_.Write("Unknown action: " + std::string(command.substr(0, command.find(' '))), LogColor{ 1.0f, 0.5f, 0.0f, 1.0f });
+            break;
+        case CommandResult::MissingTarget:
+            log_.Write("Error: No technique specified in command", LogColor{ 1.0f, 0.5f, 0.0f, 1.0f });
+            break;
+        case CommandResult::MissingValue:
+            log_.Write("Error: No value specified in command", LogColor{ 1.0f, 0.5f, 0.0f, 1.0f });
+            break;
+        case CommandResult::InvalidValue:
+            log_.Write("Error: Invalid value in command: " + std::string(command), LogColor{ 1.0f, 0.5f, 0.0f, 1.0f });
+            break;
+        case CommandResult::TooManyValues:
+            log_.Write("Error: Too many values in command: " + std::string(command), LogColor{ 1.0f, 0.5f, 0.0f, 1.0f });
+            break;
+        case CommandResult::InvalidDuration:
+            log_.Write("Error: Invalid duration in command: " + std::string(command), LogColor{ 1.0f, 0.5f, 0.0f, 1.0f });
+            break;
+        case CommandResult::UnknownEasing:
+            log_.Write("Error: Unknown easing in command: " + std::string(command), LogColor{ 1.0f, 0.5f, 0.0f, 1.0f });
+            break;
+        case CommandResult::LeaseNeedsEnable:
+            log_.Write("Error: FOR only applies to ENABLE: " + std::string(command), LogColor{ 1.0f, 0.5f, 0.0f, 1.0f });
+            break;
+        case CommandResult::InvalidSchedule:
+            log_.Write("Error: Invalid schedule in command: " + std::string(command), LogColor{ 1.0f, 0.5f, 0.0f, 1.0f });
+            break;
+        case CommandResult::InvalidPriority:
+            log_.Write("Error: Invalid priority in command: " + std::string(command), LogColor{ 1.0f, 0.5f, 0.0f, 1.0f });
+            break;
+        default:
+            log_.Write("Error: Technique name too long", LogColor{ 1.0f, 0.5f, 0.0f, 1.0f });
+            break;
+        }
+    }
+
+    void CommandEngine::Rebuild(EffectRuntime& runtime) {
+        techniques_.Rebuild(runtime);
+        uniforms_.Rebuild(runtime);
+        tweens_.Clear();    // Handles from the previous load are no longer valid
+        active_tweens_.store(0, std::memory_order_relaxed);
+        ResetLeases();
+        ResetIntents();
+        runtime_available_.store(true, std::memory_order_release);
+
+        log_.Write("Updated available techniques: " + std::to_string(techniques_.Size()) + " found",
+            LogColor{ 0.7f, 0.7f, 1.0f, 1.0f });
+        log_.Write("Updated available uniforms: " + std::to_string(uniforms_.Size()) + " found",
+            LogColor{ 0.7f, 0.7f, 1.0f, 1.0f });
+    }
+
+    void CommandEngine::Clear() {
+        runtime_available_.store(false, std::memory_order_release);
+        techniques_.Clear();
+        uniforms_.Clear();
+        tweens_.Clear();
+        active_tweens_.store(0, std::memory_order_relaxed);
+        ResetLeases();
+        ResetIntents();
+        ClearScheduled();
+    }
+
+    void CommandEngine::Drain(EffectRuntime& runtime) {
+        const uint64_t frame = frames_.Tick() + 1;     // The frame that commands applied now are rendered into
+
+        // Commands applied during the previous frame are on screen as of this present
+        const int64_t present_ns = MonotonicNs();
+        for (const AppliedCommand& applied : awaiting_present_) {
+            RecordLatency(LatencyStage::Present, present_ns - applied.applied_ns);
+            RecordLatency(LatencyStage::Total, present_ns - applied.received_ns);
+        }
+        awaiting_present_.clear();
+
+        lease_timers_.Advance(present_ns, [&](const LeaseTimer& timer) {
+            ExpireLease(timer);
+            });
+        ReleaseScheduled(runtime, frame, present_ns);
+
+        // The high lane is emptied every frame; the low lane gets what its budget allows, and
+        // the rest waits for the next frame
+        DrainLane(runtime, CommandPriority::High, COMMAND_QUEUE_CAPACITY, frame, present_ns);
+        DrainLane(runtime, CommandPriority::Low, (size_t)low_priority_budget_.load(std::memory_order_relaxed), frame, present_ns);
+        FlushTechniques(runtime, present_ns);
+
+        tweens_.Evaluate(runtime, present_ns);
+        active_tweens_.store((int)tweens_.Active(), std::memory_order_relaxed);
+
+        if (replies_queued_) {
+            replies_queued_ = false;
+            if (reply_notifier_) reply_notifier_();
+        }
+    }
+
+    // Applies up to budget commands from one lane, finishing any batch it has started
+    void CommandEngine::DrainLane(EffectRuntime& runtime, CommandPriority priority, size_t budget, uint64_t frame, int64_t present_ns) {
+        auto& queue = queues_[(size_t)priority];
+        PendingCommand command;
+        // Bound the drain so a flood cannot keep a single frame busy forever, but never stop
+        // in the middle of a batch
+        uint16_t batch_remaining = 0;
+        for (size_t i = 0; (i < budget || batch_remaining > 0) && queue.TryPop(command); ++i) {
+            const bool batched = batch_remaining > 0 || command.batch_remaining > 0;
+            batch_remaining = command.batch_remaining;
+            if (command.at_frame > frame || command.at_ns > present_ns) {
+                Schedule(command);
+                continue;
+            }
+            if (command.at_frame > 0 || command.at_ns > 0) {
+                ApplyScheduled(runtime, command, frame, present_ns);
+                continue;
+            }
+            Apply(runtime, command, batched);
+            const int64_t applied_ns = MonotonicNs();
+            RecordLatency(LatencyStage::Apply, applied_ns - command.enqueued_ns);
+            awaiting_present_.push_back(AppliedCommand{ command.received_ns, applied_ns });
+            commands_applied_.fetch_add(1, std::memory_order_relaxed);
+        }
+        queue.PublishConsumerPosition();
+    }
+
+    void CommandEngine::ResetLatency() {
+        for (LatencyHistogram& histogram : latency_) {
+            histogram.Reset();
+        }
+    }
+
+    void CommandEngine::Apply(EffectRuntime& runtime, const PendingCommand& command, bool batched) {
+        switch (command.action) {
+        case CommandAction::Set: ApplySet(runtime, command); break;
+        case CommandAction::Get: ApplyGet(runtime, command); break;
+        case CommandAction::Tween: ApplyTween(command); break;
+        case CommandAction::Debounce: ApplyDebounce(command); break;
+        case CommandAction::BatchBegin:
+        case CommandAction::BatchCommit:
+        case CommandAction::BatchAbort:
+            break;  // Handled when submitted
+        default: ApplyTechnique(command, batched); break;
+        }
+    }
+
+    // Parks an AT command until its frame or time comes up
+    void CommandEngine::Schedule(const PendingCommand& command) {
+        if (frame_schedule_.size() + time_schedule_.size() >= MAX_SCHEDULED_COMMANDS) {
+            commands_dropped_++;
+            log_.Write("Too many scheduled commands, dropped: " + std::string(command.Target()), LogColor{ 1.0f, 0.0f, 0.0f, 1.0f });
+            if (command.action == CommandAction::Get) Reply(command.client_id, CommandResultReply(CommandResult::QueueFull));
+            return;
+        }
+
+        uint32_t slot;
+        if (!free_scheduled_.empty()) {
+            slot = free_scheduled_.back();
+            free_scheduled_.pop_back();
+            scheduled_commands_[slot] = command;
+        }
+        else {
+            slot = (uint32_t)scheduled_commands_.size();
+            scheduled_commands_.push_back(command);
+        }
+
+        if (command.at_frame > 0) {
+            frame_schedule_.push(ScheduledCommand{ command.at_frame, next_schedule_sequence_++, slot });
+        }
+        else {
+            time_schedule_.push(ScheduledCommand{ (uint64_t)command.at_ns, next_schedule_sequence_++, slot });
+        }
+        scheduled_count_.store((int)(frame_schedule_.size() + time_schedule_.size()), std::memory_order_relaxed);
+    }
+
+    // Applies every scheduled command whose frame or time has come, earliest first
+    void CommandEngine::ReleaseScheduled(EffectRuntime& runtime, uint64_t frame, int64_t now_ns) {
+        if (frame_schedule_.empty() && time_schedule_.empty()) return;
+
+        auto release = [&](ScheduleHeap& heap, uint64_t due) {
+            while (!heap.empty() && heap.top().key <= due) {
+                const uint32_t slot = heap.top().slot;
+                heap.pop();
+                ApplyScheduled(runtime, scheduled_commands_[slot], frame, now_ns);
+                free_scheduled_.push_back(slot);
+            }
+        };
+        release(frame_schedule_, frame);
+        release(time_schedule_, (uint64_t)now_ns);
+        scheduled_count_.store((int)(frame_schedule_.size() + time_schedule_.size()), std::memory_order_relaxed);
+    }
+
+    // Applies a scheduled command and logs how far it landed from where it was scheduled
+    void CommandEngine::ApplyScheduled(EffectRuntime& runtime, const PendingCommand& command, uint64_t frame, int64_t now_ns) {
+        if (command.at_frame > 0) {
+            log_.Write("Scheduled " + std::string(command.Target()) + " for frame " + std::to_string(command.at_frame) +
+                ", ran on frame " + std::to_string(frame), LogColor{ 0.7f, 0.7f, 1.0f, 1.0f });
+        }
+        else {
+            log_.Write("Scheduled " + std::string(command.Target()) + " ran on frame " + std::to_string(frame) + ", " +
+                std::to_string((now_ns - command.at_ns) / 1000) + " us after its time", LogColor{ 0.7f, 0.7f, 1.0f, 1.0f });
+        }
+        Apply(runtime, command, false);
+        commands_applied_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void CommandEngine::ClearScheduled() {
+        scheduled_commands_.clear();
+        free_scheduled_.clear();
+        frame_schedule_ = ScheduleHeap();
+        time_schedule_ = ScheduleHeap();
+        scheduled_count_.store(0, std::memory_order_relaxed);
+    }
+
+    // Updates leases and folds the command into each matching technique's intent; the runtime
+    // is written once the frame's commands have all been folded
+    void CommandEngine::ApplyTechnique(const PendingCommand& command, bool batched) {
+        const int64_t now_ns = MonotonicNs();
+        size_t found = techniques_.ForEachMatch(command.Target(), [&](const TechniqueCatalog::Entry& entry) {
+            const uint32_t index = techniques_.IndexOf(entry);
+            Lease& lease = leases_[index];
+            if (command.duration_ns > 0) {
+                if (lease.count == 0) {
+                    lease.generation = next_lease_generation_++;
+                }
+                lease.count++;
+                active_leases_.fetch_add(1, std::memory_order_relaxed);
+                lease_timers_.Schedule(now_ns + command.duration_ns, LeaseTimer{ index, lease.generation });
+                log_.Write("Lease on " + entry.name + " for " + std::to_string(command.duration_ns / 1000000) + " ms (" +
+                    std::to_string(lease.count) + " active)", LogColor{ 0.0f, 1.0f, 0.0f, 1.0f });
+            }
+            else if (lease.count > 0) {
+                // An explicit command takes over from the leases
+                active_leases_.fetch_sub((int)lease.count, std::memory_order_relaxed);
+                lease.count = 0;
+            }
+
+            FoldTechnique(index, command.action, batched);
+            });
+
+        if (found == 0) {
+            log_.Write("Technique not found: " + std::string(command.Target()), LogColor{ 1.0f, 0.5f, 0.0f, 1.0f });
+        }
+    }
+
+    void CommandEngine::FoldTechnique(uint32_t index, CommandAction action, bool batched) {
+        TechniqueIntent& intent = intents_[index];
+        switch (action) {
+        case CommandAction::Toggle:
+            intent.flip = !intent.flip;
+            break;
+        case CommandAction::Enable:
+        case CommandAction::Disable:
+            intent.has_state = true;
+            intent.state = action == CommandAction::Enable;
+            intent.flip = false;
+            break;
+        default:
+            return;
+        }
+
+        intent.commands++;
+        intent.batched = intent.batched || batched;
+        if (!intent.pending) {
+            intent.pending = true;
+            dirty_techniques_.push_back(index);
+        }
+    }
+
+    // Writes each technique's folded commands with one runtime call, skipping the call when the
+    // state does not change. Techniques inside their debounce window stay pending, and keep
+    // folding, until the window ends, unless a batch wrote them: a batch always lands in one frame.
+    void CommandEngine::FlushTechniques(EffectRuntime& runtime, int64_t now_ns) {
+        size_t held = 0;
+        for (uint32_t index : dirty_techniques_) {
+            TechniqueIntent& intent = intents_[index];
+            if (!intent.batched && intent.debounce_ns > 0 && intent.last_change_ns != 0 &&
+                now_ns - intent.last_change_ns < intent.debounce_ns) {
+                dirty_techniques_[held++] = index;
+                continue;
+            }
+
+            const TechniqueCatalog::Entry& entry = techniques_[index];
+            const bool current_state = runtime.GetTechniqueState(entry.handle);
+            const bool new_state = (intent.has_state ? intent.state : current_state) != intent.flip;
+            if (new_state != current_state) {
+                runtime.SetTechniqueState(entry.handle, new_state);
+                intent.last_change_ns = now_ns;
+            }
+
+            const std::string_view state_str = new_state ? "ON" : "OFF";
+            if (intent.commands > 1) {
+                log_.Write({ "Set ", entry.name, " to ", state_str, " (", std::to_string(intent.commands), " commands)" },
+                    LogColor{ 0.0f, 1.0f, 0.0f, 1.0f });
+                commands_coalesced_.fetch_add((int)intent.commands - 1, std::memory_order_relaxed);
+            }
+            else {
+                log_.Write({ "Set ", entry.name, " to ", state_str }, LogColor{ 0.0f, 1.0f, 0.0f, 1.0f });
+            }
+
+            intent.pending = false;
+            intent.has_state = false;
+            intent.flip = false;
+            intent.commands = 0;
+            intent.batched = false;
+        }
+        dirty_techniques_.resize(held);
+    }
+
+    void CommandEngine::ResetIntents() {
+        intents_.assign(techniques_.Size(), TechniqueIntent{});
+        dirty_techniques_.clear();
+        if (debounce_windows_.empty()) return;
+        for (size_t i = 0; i < techniques_.Size(); ++i) {
+            auto window = debounce_windows_.find(techniques_[i].name);
+            if (window != debounce_windows_.end()) {
+                intents_[i].debounce_ns = window->second;
+            }
+        }
+    }
+
+    void CommandEngine::ApplyDebounce(const PendingCommand& command) {
+        size_t found = techniques_.ForEachMatch(command.Target(), [&](const TechniqueCatalog::Entry& entry) {
+            intents_[techniques_.IndexOf(entry)].debounce_ns = command.duration_ns;
+            if (command.duration_ns > 0) {
+                debounce_windows_[entry.name] = command.duration_ns;
+                log_.Write("Debounce " + entry.name + ": " + std::to_string(command.duration_ns / 1000000) + " ms",
+                    LogColor{ 0.0f, 1.0f, 0.0f, 1.0f });
+            }
+            else {
+                debounce_windows_.erase(entry.name);
+                log_.Write("Debounce " + entry.name + " off", LogColor{ 0.0f, 1.0f, 0.0f, 1.0f });
+            }
+            });
+
+        if (found == 0) {
+            log_.Write("Technique not found: " + std::string(command.Target()), LogColor{ 1.0f, 0.5f, 0.0f, 1.0f });
+        }
+    }
+
+    void CommandEngine::ExpireLease(const LeaseTimer& timer) {
+        Lease& lease = leases_[timer.technique];
+        if (lease.count == 0 || lease.generation != timer.generation) return;
+
+        lease.count--;
+        active_leases_.fetch_sub(1, std::memory_order_relaxed);
+        if (lease.count > 0) return;
+
+        FoldTechnique(timer.technique, CommandAction::Disable, false);
+        log_.Write("Lease expired on " + techniques_[timer.technique].name, LogColor{ 0.0f, 1.0f, 0.0f, 1.0f });
+    }
+
+    void CommandEngine::ResetLeases() {
+        leases_.assign(techniques_.Size(), Lease{});
+        lease_timers_.Clear();
+        active_leases_.store(0, std::memory_order_relaxed);
+    }
+
+    void CommandEngine::ApplySet(EffectRuntime& runtime, const PendingCommand& command) {
+        const UniformCatalog::Entry* uniform = uniforms_.Find(command.Target());
+        if (!uniform) {
+            log_.Write("Uniform not found: " + std::string(command.Target()), LogColor{ 1.0f, 0.5f, 0.0f, 1.0f });
+            return;
+        }
+
+        const size_t components = uniform->type.Components();
+        if (command.value_count > components) {
+            log_.Write(uniform->name + " takes " + std::to_string(components) + " values, got " + std::to_string(command.value_count),
+                LogColor{ 1.0f, 0.5f, 0.0f, 1.0f });
+            return;
+        }
+
+        tweens_.Cancel(uniform->handle);
+        WriteUniformValues(runtime, uniform->handle, uniform->type.base, command.values, command.value_count);
+
+        log_.Write({ "Set ", uniform->name }, LogColor{ 0.0f, 1.0f, 0.0f, 1.0f });
+    }
+
+    void CommandEngine::ApplyTween(const PendingCommand& command) {
+        const UniformCatalog::Entry* uniform = uniforms_.Find(command.Target());
+        if (!uniform) {
+            log_.Write("Uniform not found: " + std::string(command.Target()), LogColor{ 1.0f, 0.5f, 0.0f, 1.0f });
+            return;
+        }
+
+        // A single start or end value applies to every component the other one covers, or to
+        // all of the uniform's components when both are single values
+        const size_t from_count = command.from_count;
+        const size_t to_count = command.value_count - command.from_count;
+        const size_t covered = (from_count == 1 && to_count == 1) ? uniform->type.Components() : std::max(from_count, to_count);
+        const size_t count = std::min({ covered, uniform->type.Components(), MAX_UNIFORM_VALUES });
+        float from[MAX_UNIFORM_VALUES];
+        float to[MAX_UNIFORM_VALUES];
+        for (size_t i = 0; i < count; ++i) {
+            from[i] = (float)command.values[from_count == 1 ? 0 : i];
+            to[i] = (float)command.values[from_count + (to_count == 1 ? 0 : i)];
+        }
+
+        tweens_.Start(uniform->handle, uniform->type.base, from, to, count, command.duration_ns, command.easing, MonotonicNs());
+        log_.Write("Tween " + uniform->name + " over " + std::to_string(command.duration_ns / 1000000) + " ms",
+            LogColor{ 0.0f, 1.0f, 0.0f, 1.0f });
+    }
+
+    void CommandEngine::ApplyGet(EffectRuntime& runtime, const PendingCommand& command) {
+        const UniformCatalog::Entry* uniform = uniforms_.Find(command.Target());
+        if (!uniform) {
+            log_.Write("Uniform not found: " + std::string(command.Target()), LogColor{ 1.0f, 0.5f, 0.0f, 1.0f });
+            Reply(command.client_id, "ERROR uniform not found");
+            return;
+        }
+
+        // "VALUE <name> <value>..."
+        char text[MAX_REPLY_LENGTH];
+        char* out = text;
+        char* const end = text + sizeof(text);
+        const std::string_view prefix = "VALUE ";
+        memcpy(out, prefix.data(), prefix.size());
+        out += prefix.size();
+        const size_t name_length = std::min(uniform->name.size(), MAX_TARGET_LENGTH);
+        memcpy(out, uniform->name.data(), name_length);
+        out += name_length;
+
+        const size_t count = std::min(uniform->type.Components(), MAX_UNIFORM_VALUES);
+        switch (uniform->type.base) {
+        case UniformBaseType::Bool: FormatUniform<bool>(runtime, uniform->handle, count, out, end); break;
+        case UniformBaseType::Int: FormatUniform<int32_t>(runtime, uniform->handle, count, out, end); break;
+        case UniformBaseType::Uint: FormatUniform<uint32_t>(runtime, uniform->handle, count, out, end); break;
+        case UniformBaseType::Float: FormatUniform<float>(runtime, uniform->handle, count, out, end); break;
+        }
+
+        Reply(command.client_id, std::string_view(text, out - text));
+    }
+
+    void CommandEngine::Reply(uint32_t client_id, std::string_view text) {
+        if (client_id == 0) return;
+
+        CommandReply reply;
+        reply.client_id = client_id;
+        reply.length = (uint16_t)std::min(text.size(), MAX_REPLY_LENGTH);
+        memcpy(reply.text, text.data(), reply.length);
+        if (!replies_.TryPush(reply)) {
+            log_.Write("Reply queue full, dropped reply", LogColor{ 1.0f, 0.0f, 0.0f, 1.0f });
+            return;
+        }
+        replies_queued_ = true;
+    }
+
+}
@@ -0,0 +1,194 @@
+#pragma once
+#include "command.hpp"
+#include "effect_runtime.hpp"
+#include "frame_clock.hpp"
+#include "latency_histogram.hpp"
+#include "log_ring.hpp"
+#include "mpsc_queue.hpp"
+#include "technique_catalog.hpp"
+#include "timer_wheel.hpp"
+#include "tween_engine.hpp"
+#include "uniform_catalog.hpp"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <string_view>
+#include <vector>
+
+namespace streamerbot {
+
+    constexpr size_t COMMAND_QUEUE_CAPACITY = 1024;  // Must be a power of two
+    constexpr size_t REPLY_QUEUE_CAPACITY = 256;     // Must be a power of two
+    constexpr int64_t LEASE_TICK_NS = 1000000;       // Lease expiry resolution (1 ms)
+    constexpr size_t MAX_SCHEDULED_COMMANDS = 1024;  // AT commands waiting for their frame or time
+    constexpr int DEFAULT_LOW_PRIORITY_BUDGET = 128; // Low-lane commands applied per frame
+    static_assert(MAX_BATCH_COMMANDS <= COMMAND_QUEUE_CAPACITY, "a batch must fit in the command queue");
+
+    // Per-connection command state: where render-thread replies go and the batch being staged
+    // between BEGIN and COMMIT. Owned by whoever submits for that connection.
+    struct CommandSource {
+        uint32_t client_id = 0;
+        CommandPriority priority = CommandPriority::Low;       // Lane for commands without a PRIORITY prefix
+        bool batch_open = false;
+        CommandResult batch_error = CommandResult::Queued;     // First error while staging; rejects the batch
+        std::vector<PendingCommand> batch;
+    };
+
+    // Parses commands on the network thread and applies them on the render thread. The two
+    // sides only share the command queue, the reply queue and a few counters.
+    class CommandEngine {
+    public:
+        explicit CommandEngine(LogRing& log) : log_(log) {}
+
+        // Parses a command line and queues it for the render thread. Never touches the
+        // runtime. Safe to call from any thread, as long as each source is only used by one
+        // thread at a time. received_ns is the MonotonicNs() at which the line arrived.
+        // A line of ';'-separated commands, like a BEGIN/COMMIT batch, is queued as one batch
+        // that the render thread applies within a single frame, and gets a single reply.
+        CommandResult Submit(std::string_view command, int64_t received_ns, CommandSource& source);
+        CommandResult Submit(std::string_view command, int64_t received_ns) {
+            CommandSource source;
+            return Submit(command, received_ns, source);
+        }
+
+        // Network thread: takes the next reply produced by the render thread
+        bool TryPopReply(CommandReply& reply) { return replies_.TryPop(reply); }
+        // Called on the render thread after a drain queued replies. Set once, before the
+        // render thread starts draining.
+        void SetReplyNotifier(std::function<void()> notify) { reply_notifier_ = std::move(notify); }
+
+        // Render thread only
+        void Rebuild(EffectRuntime& runtime);
+        void Clear();
+        // Applies every command queued since the previous frame; called once per present
+        void Drain(EffectRuntime& runtime);
+
+        const FrameClock& Frames() const { return frames_; }
+
+        const TechniqueCatalog& Techniques() const { return techniques_; }
+        const UniformCatalog& Uniforms() const { return uniforms_; }
+        int CommandsReceived() const { return commands_received_.load(); }
+        int CommandsDropped() const { return commands_dropped_.load(); }
+        int CommandsApplied() const { return commands_applied_.load(std::memory_order_relaxed); }
+        int ParseErrors() const { return parse_errors_.load(); }
+        int CommandsCoalesced() const { return commands_coalesced_.load(std::memory_order_relaxed); }
+        size_t Queued() const { return queues_[0].ApproxSize() + queues_[1].ApproxSize(); }
+        size_t Queued(CommandPriority priority) const { return queues_[(size_t)priority].ApproxSize(); }
+        // Low-lane commands applied per frame once the high lane is empty. Safe to call from
+        // any thread.
+        void SetLowPriorityBudget(int commands) { low_priority_budget_.store((std::max)(commands, 1), std::memory_order_relaxed); }
+        int ActiveTweens() const { return active_tweens_.load(std::memory_order_relaxed); }
+        int ActiveLeases() const { return active_leases_.load(std::memory_order_relaxed); }
+        int ScheduledCommands() const { return scheduled_count_.load(std::memory_order_relaxed); }
+
+        const LatencyHistogram& Latency(LatencyStage stage) const { return latency_[(size_t)stage]; }
+        void ResetLatency();
+
+    private:
+        // Outstanding ENABLE ... FOR leases on one technique. The technique is switched off
+        // when the last one expires; any other command on it cancels them all.
+        struct Lease {
+            uint32_t count = 0;
+            uint32_t generation = 0;    // Timers from an earlier, cancelled set of leases are ignored
+        };
+
+        // Technique commands folded since the technique was last written. TOGGLEs fold to their
+        // parity and ENABLE/DISABLE overrides everything before it, so however many commands
+        // arrive, the technique gets at most one runtime call per frame, and at most one per
+        // debounce window outside batches.
+        struct TechniqueIntent {
+            bool pending = false;       // Listed in dirty_techniques_
+            bool has_state = false;     // An ENABLE/DISABLE was folded: the result ignores the current state
+            bool state = false;
+            bool flip = false;          // Odd number of TOGGLEs since
+            uint32_t commands = 0;
+            bool batched = false;       // Folded from a batch: written this frame, even inside the debounce window
+            int64_t debounce_ns = 0;    // Minimum time between state changes; 0 for none
+            int64_t last_change_ns = 0;
+        };
+
+        struct LeaseTimer {
+            uint32_t technique;         // Index in techniques_
+            uint32_t generation;
+        };
+
+        // Heap entry for an AT command parked in scheduled_commands_. Equal keys run in
+        // arrival order.
+        struct ScheduledCommand {
+            uint64_t key;               // Frame index or MonotonicNs(), depending on the heap
+            uint64_t sequence;
+            uint32_t slot;              // Index in scheduled_commands_
+
+            bool operator>(const ScheduledCommand& other) const {
+                return key != other.key ? key > other.key : sequence > other.sequence;
+            }
+        };
+        using ScheduleHeap = std::priority_queue<ScheduledCommand, std::vector<ScheduledCommand>, std::greater<ScheduledCommand>>;
+
+        // Command applied this frame, waiting for the present that shows it
+        struct AppliedCommand {
+            int64_t received_ns;
+            int64_t applied_ns;
+        };
+
+        CommandResult SubmitOne(std::string_view command, int64_t received_ns, CommandSource& source);
+        CommandResult CommitBatch(CommandSource& source);
+        CommandResult Enqueue(PendingCommand* commands, size_t count);
+        void DrainLane(EffectRuntime& runtime, CommandPriority priority, size_t budget, uint64_t frame, int64_t present_ns);
+        void LogParseError(CommandResult result, std::string_view command);
+        void Apply(EffectRuntime& runtime, const PendingCommand& command, bool batched);
+        void Schedule(const PendingCommand& command);
+        void ReleaseScheduled(EffectRuntime& runtime, uint64_t frame, int64_t now_ns);
+        void ApplyScheduled(EffectRuntime& runtime, const PendingCommand& command, uint64_t frame, int64_t now_ns);
+        void ClearScheduled();
+        void ApplyTechnique(const PendingCommand& command, bool batched);
+        void FoldTechnique(uint32_t index, CommandAction action, bool batched);
+        void FlushTechniques(EffectRuntime& runtime, int64_t now_ns);
+        void ResetIntents();
+        void ApplyDebounce(const PendingCommand& command);
+        void ExpireLease(const LeaseTimer& timer);
+        void ResetLeases();
+        void ApplySet(EffectRuntime& runtime, const PendingCommand& command);
+        void ApplyGet(EffectRuntime& runtime, const PendingCommand& command);
+        void ApplyTween(const PendingCommand& command);
+        void Reply(uint32_t client_id, std::string_view text);
+        void RecordLatency(LatencyStage stage, int64_t duration_ns) { latency_[(size_t)stage].Record(duration_ns); }
+
+        LogRing& log_;
+        TechniqueCatalog techniques_;                                // Render thread only
+        UniformCatalog uniforms_;                                    // Render thread only
+        TweenEngine tweens_;                                         // Render thread only
+        std::vector<Lease> leases_;                                  // Indexed like techniques_; render thread only
+        std::vector<TechniqueIntent> intents_;                       // Indexed like techniques_; render thread only
+        std::vector<uint32_t> dirty_techniques_;                     // Techniques with a pending intent
+        std::unordered_map<std::string, int64_t> debounce_windows_;  // Technique name -> window; kept across reloads
+        TimerWheel<LeaseTimer> lease_timers_{ LEASE_TICK_NS };       // Render thread only
+        uint32_t next_lease_generation_ = 1;
+        std::vector<PendingCommand> scheduled_commands_;             // AT commands; render thread only
+        std::vector<uint32_t> free_scheduled_;                       // Unused slots in scheduled_commands_
+        ScheduleHeap frame_schedule_;                                // AT frame+N, keyed by frame index
+        ScheduleHeap time_schedule_;                                 // AT t+<duration>, keyed by MonotonicNs()
+        uint64_t next_schedule_sequence_ = 0;
+        FrameClock frames_;
+        std::vector<AppliedCommand> awaiting_present_;               // Render thread only
+        LatencyHistogram latency_[(size_t)LatencyStage::Count];
+        MpscQueue<PendingCommand, COMMAND_QUEUE_CAPACITY> queues_[COMMAND_PRIORITY_COUNT];     // Network thread -> render thread, per lane
+        std::atomic<int> low_priority_budget_{ DEFAULT_LOW_PRIORITY_BUDGET };
+        MpscQueue<CommandReply, REPLY_QUEUE_CAPACITY> replies_;      // Render thread -> network thread
+        std::function<void()> reply_notifier_;
+        bool replies_queued_ = false;                                // Render thread only
+        std::atomic<bool> runtime_available_{ false };
+        std::atomic<int> commands_received_{ 0 };
+        std::atomic<int> commands_dropped_{ 0 };
+        std::atomic<int> parse_errors_{ 0 };
+        std::atomic<int> commands_applied_{ 0 };
+        std::atomic<int> commands_coalesced_{ 0 };
+        std::atomic<int> active_tweens_{ 0 };
+        std::atomic<int> active_leases_{ 0 };
+        std::atomic<int> scheduled_count_{ 0 };
+    };
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+namespace streamerbot {
+
+    // Opaque technique handle; the value of reshade::api::effect_technique::handle
+    using TechniqueHandle = uint64_t;
+    // Opaque uniform variable handle; the value of reshade::api::effect_uniform_variable::handle
+    using UniformHandle = uint64_t;
+
+    // Scalar type of a uniform variable, from get_uniform_variable_type()
+    enum class UniformBaseType : uint8_t {
+        Bool,
+        Int,
+        Uint,
+        Float,
+    };
+
+    struct UniformType {
+        UniformBaseType base = UniformBaseType::Float;
+        uint32_t rows = 1;
+        uint32_t columns = 1;
+        uint32_t array_length = 0;      // 0 for variables that are not arrays
+
+        size_t Components() const { return (size_t)rows * columns * (array_length ? array_length : 1); }
+    };
+
+    // The part of reshade::api::effect_runtime the command engine uses. The addon implements
+    // it on top of the real runtime; keeping the engine behind this interface lets it build
+    // without the ReShade headers, which rely on MSVC extensions.
+    class EffectRuntime {
+    public:
+        virtual ~EffectRuntime() = default;
+
+        // Calls callback once per technique of every loaded effect
+        virtual void EnumerateTechniques(const std::function<void(TechniqueHandle technique, std::string_view name)>& callback) = 0;
+        virtual bool GetTechniqueState(TechniqueHandle technique) = 0;
+        virtual void SetTechniqueState(TechniqueHandle technique, bool enabled) = 0;
+
+        // Calls callback once per uniform variable of every loaded effect
+        virtual void EnumerateUniforms(const std::function<void(UniformHandle variable, std::string_view effect_name,
+            std::string_view variable_name, const UniformType& type)>& callback) = 0;
+        // Read or write the first count components of a uniform, matching its base type
+        virtual void GetUniformValues(UniformHandle variable, bool* values, size_t count) = 0;
+        virtual void GetUniformValues(UniformHandle variable, int32_t* values, size_t count) = 0;
+        virtual void GetUniformValues(UniformHandle variable, uint32_t* values, size_t count) = 0;
+        virtual void GetUniformValues(UniformHandle variable, float* values, size_t count) = 0;
+        virtual void SetUniformValues(UniformHandle variable, const bool* values, size_t count) = 0;
+        virtual void SetUniformValues(UniformHandle variable, const int32_t* values, size_t count) = 0;
+        virtual void SetUniformValues(UniformHandle variable, const uint32_t* values, size_t count) = 0;
+        virtual void SetUniformValues(UniformHandle variable, const float* values, size_t count) = 0;
+    };
+
+}
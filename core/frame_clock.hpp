@@ -0,0 +1,43 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace streamerbot {
+
+    // Counts presented frames and tracks the frame time. Ticked by the render thread once per
+    // present; readable from any thread.
+    class FrameClock {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        // Records a present. Returns the index of the frame that was just presented.
+        uint64_t Tick(Clock::time_point now = Clock::now()) {
+            int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+            int64_t last_ns = last_present_ns_.load(std::memory_order_relaxed);
+            if (last_ns != 0) {
+                // Exponential moving average over roughly the last 16 frames
+                int64_t frame_ns = now_ns - last_ns;
+                int64_t average = frame_time_ns_.load(std::memory_order_relaxed);
+                frame_time_ns_.store(average == 0 ? frame_ns : average + (frame_ns - average) / 16, std::memory_order_relaxed);
+            }
+            last_present_ns_.store(now_ns, std::memory_order_relaxed);
+            return frame_.fetch_add(1, std::memory_order_release);
+        }
+
+        // Number of frames presented so far, which is also the index of the next frame
+        uint64_t Frame() const { return frame_.load(std::memory_order_acquire); }
+
+        Clock::time_point LastPresent() const {
+            return Clock::time_point(std::chrono::nanoseconds(last_present_ns_.load(std::memory_order_relaxed)));
+        }
+
+        double FrameTimeMs() const { return (double)frame_time_ns_.load(std::memory_order_relaxed) / 1e6; }
+
+    private:
+        std::atomic<uint64_t> frame_{ 0 };
+        std::atomic<int64_t> last_present_ns_{ 0 };
+        std::atomic<int64_t> frame_time_ns_{ 0 };
+    };
+
+}
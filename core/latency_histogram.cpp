@@ -0,0 +1,54 @@
+#include "latency_histogram.hpp"
+#include <algorithm>
+
+namespace streamerbot {
+
+    const char* LatencyStageName(LatencyStage stage) {
+        switch (stage) {
+        case LatencyStage::Parse: return "Parse";
+        case LatencyStage::Enqueue: return "Enqueue";
+        case LatencyStage::Apply: return "Apply";
+        case LatencyStage::Present: return "Present";
+        case LatencyStage::Total: return "Total";
+        case LatencyStage::Count: break;
+        }
+        return "";
+    }
+
+    LatencySummary LatencyHistogram::Summarize() const {
+        uint64_t counts[BUCKET_COUNT];
+        LatencySummary summary;
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            counts[i] = counts_[i].load(std::memory_order_relaxed);
+            summary.count += counts[i];
+        }
+        summary.max_ns = max_ns_.load(std::memory_order_relaxed);
+        if (summary.count == 0) return summary;
+
+        // Ranks are rounded up so that p99 of a small sample is its largest value
+        const uint64_t p50_rank = (summary.count * 50 + 99) / 100;
+        const uint64_t p90_rank = (summary.count * 90 + 99) / 100;
+        const uint64_t p99_rank = (summary.count * 99 + 99) / 100;
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKET_COUNT && seen < p99_rank; ++i) {
+            if (counts[i] == 0) continue;
+            uint64_t before = seen;
+            seen += counts[i];
+            uint64_t value = std::min(BucketUpperBound(i), summary.max_ns);
+            if (before < p50_rank && seen >= p50_rank) summary.p50_ns = value;
+            if (before < p90_rank && seen >= p90_rank) summary.p90_ns = value;
+            if (before < p99_rank && seen >= p99_rank) summary.p99_ns = value;
+        }
+        return summary;
+    }
+
+    void LatencyHistogram::Reset() {
+        for (auto& count : counts_) {
+            count.store(0, std::memory_order_relaxed);
+        }
+        sum_ns_.store(0, std::memory_order_relaxed);
+        max_ns_.store(0, std::memory_order_relaxed);
+    }
+
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace streamerbot {
+
+    // Monotonic timestamp in nanoseconds, used for command latency
+    inline int64_t MonotonicNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Command pipeline stages, each measured from the end of the previous one. Total runs
+    // from receive to the first present after the command was applied.
+    enum class LatencyStage {
+        Parse,       // Received -> parsed
+        Enqueue,     // Parsed -> queued for the render thread
+        Apply,       // Queued -> applied to the runtime
+        Present,     // Applied -> next present
+        Total,       // Received -> next present
+        Count,
+    };
+
+    const char* LatencyStageName(LatencyStage stage);
+
+    struct LatencySummary {
+        uint64_t count = 0;
+        uint64_t p50_ns = 0;
+        uint64_t p90_ns = 0;
+        uint64_t p99_ns = 0;
+        uint64_t max_ns = 0;
+    };
+
+    // Log-linear (HDR-style) histogram of durations. Each power of two is split into
+    // SUB_BUCKETS linear buckets, so percentiles are accurate to within 1/SUB_BUCKETS of the
+    // value. Recording is one bucket computation and relaxed atomic adds; readers
+    // summarize without stopping the writers.
+    class LatencyHistogram {
+    public:
+        static constexpr int SUB_BUCKET_BITS = 3;
+        static constexpr uint64_t SUB_BUCKETS = 1ull << SUB_BUCKET_BITS;
+        static constexpr size_t BUCKET_COUNT = 64 * SUB_BUCKETS;
+
+        void Record(int64_t duration_ns) {
+            uint64_t value = duration_ns > 0 ? (uint64_t)duration_ns : 0;
+            counts_[BucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+            sum_ns_.fetch_add(value, std::memory_order_relaxed);
+
+            uint64_t max = max_ns_.load(std::memory_order_relaxed);
+            while (value > max && !max_ns_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {}
+        }
+
+        LatencySummary Summarize() const;
+        uint64_t SumNs() const { return sum_ns_.load(std::memory_order_relaxed); }
+        void Reset();
+
+    private:
+        static int HighestBit(uint64_t value) {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanReverse64(&index, value);
+            return (int)index;
+#else
+            return 63 - __builtin_clzll(value);
+#endif
+        }
+
+        static size_t BucketOf(uint64_t value) {
+            if (value < SUB_BUCKETS) return (size_t)value;
+            int shift = HighestBit(value) - SUB_BUCKET_BITS;
+            return (size_t)(shift + 1) * SUB_BUCKETS + (size_t)((value >> shift) & (SUB_BUCKETS - 1));
+        }
+
+        // Largest value that falls into bucket
+        static uint64_t BucketUpperBound(size_t bucket) {
+            if (bucket < SUB_BUCKETS) return bucket;
+            int shift = (int)(bucket / SUB_BUCKETS) - 1;
+            uint64_t base = SUB_BUCKETS + bucket % SUB_BUCKETS;
+            return ((base + 1) << shift) - 1;
+        }
+
+        std::atomic<uint64_t> counts_[BUCKET_COUNT] = {};
+        std::atomic<uint64_t> sum_ns_{ 0 };
+        std::atomic<uint64_t> max_ns_{ 0 };
+    };
+
+}
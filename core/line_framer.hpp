@@ -0,0 +1,91 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+
+namespace streamerbot {
+
+    constexpr size_t BUFFER_SIZE = 1024;           // Longest accepted command line
+    constexpr size_t RECV_BUFFER_SIZE = 4 * BUFFER_SIZE;
+
+    // Incremental line framer. recv() writes straight into the framer's buffer and
+    // ExtractLines() hands every complete line to the caller as a view into that buffer, so a
+    // single read can carry any number of pipelined commands and a command split across reads
+    // is reassembled before it is parsed. The WebSocket path decodes frames from the same buffer.
+    class LineFramer {
+    public:
+        char* WritePtr() { return buffer_ + size_; }
+        size_t WriteCapacity() const { return sizeof(buffer_) - size_; }
+        void Append(size_t count) { size_ += count; }
+
+        char* Data() { return buffer_; }
+        size_t Size() const { return size_; }
+
+        // Drops the first `count` buffered bytes
+        void Consume(size_t count) {
+            size_ -= count;
+            if (size_ > 0) {
+                memmove(buffer_, buffer_ + count, size_);
+            }
+            scanned_ = 0;
+        }
+
+        // Invokes on_line(std::string_view) for each complete buffered line, without its
+        // terminator. Returns false if a line exceeded BUFFER_SIZE and was dropped.
+        template <typename OnLine>
+        bool ExtractLines(OnLine&& on_line) {
+            bool ok = true;
+            size_t scan = scanned_;
+            size_t line_start = 0;
+
+            if (discarding_) {
+                // Skip the rest of an oversized line
+                const char* nl = (const char*)memchr(buffer_ + scan, '\n', size_ - scan);
+                if (!nl) {
+                    size_ = scanned_ = 0;
+                    return true;
+                }
+                line_start = scan = (size_t)(nl - buffer_) + 1;
+                discarding_ = false;
+            }
+
+            while (scan < size_) {
+                const char* nl = (const char*)memchr(buffer_ + scan, '\n', size_ - scan);
+                if (!nl) break;
+
+                size_t line_end = (size_t)(nl - buffer_);
+                size_t length = line_end - line_start;
+                if (length > 0 && buffer_[line_start + length - 1] == '\r') {
+                    --length;
+                }
+                if (length > BUFFER_SIZE) {
+                    ok = false;
+                }
+                else if (length > 0) {
+                    on_line(std::string_view(buffer_ + line_start, length));
+                }
+                line_start = scan = line_end + 1;
+            }
+
+            // Keep the trailing partial line for the next read
+            size_t remaining = size_ - line_start;
+            if (remaining > BUFFER_SIZE) {
+                discarding_ = true;
+                remaining = 0;
+                ok = false;
+            }
+            if (line_start > 0 && remaining > 0) {
+                memmove(buffer_, buffer_ + line_start, remaining);
+            }
+            size_ = scanned_ = remaining;
+            return ok;
+        }
+
+    private:
+        char buffer_[RECV_BUFFER_SIZE];
+        size_t size_ = 0;
+        size_t scanned_ = 0;    // Leading bytes already known to hold no line terminator
+        bool discarding_ = false;
+    };
+
+}
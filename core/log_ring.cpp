@@ -0,0 +1,25 @@
+#include "log_ring.hpp"
+#include <chrono>
+#include <ctime>
+
+namespace streamerbot {
+
+    void LogRing::FormatTimestamp(char (&out)[12]) {
+        thread_local time_t cached_second = 0;
+        thread_local char cached_text[12] = "";
+
+        time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+        if (now != cached_second) {
+            struct tm timeinfo = {};
+#if defined(_WIN32)
+            localtime_s(&timeinfo, &now);
+#else
+            localtime_r(&now, &timeinfo);
+#endif
+            strftime(cached_text, sizeof(cached_text), "[%H:%M:%S]", &timeinfo);
+            cached_second = now;
+        }
+        memcpy(out, cached_text, sizeof(out));
+    }
+
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <string_view>
+
+namespace streamerbot {
+
+    constexpr size_t MAX_LOG_ENTRIES = 131072;      // Must be a power of two
+    constexpr size_t MAX_LOG_MESSAGE = 160;         // Longer messages are truncated
+
+    // RGBA log line color; same layout as ImVec4
+    struct LogColor {
+        float r = 1.0f, g = 1.0f, b = 1.0f, a = 1.0f;
+    };
+
+    // Copy of one log line, owned by the reader
+    struct LogEntry {
+        char time_text[12];                 // "[HH:MM:SS]", formatted once when the entry is written
+        LogColor color;
+        uint16_t length = 0;
+        char message[MAX_LOG_MESSAGE];
+
+        std::string_view Message() const { return std::string_view(message, length); }
+    };
+
+    // Preallocated ring of fixed-size log entries. Writers claim a slot with one atomic
+    // increment and publish it through the slot's sequence number (a per-slot seqlock), so
+    // writing never blocks and the overlay can read entries without stopping the writers.
+    class LogRing {
+    public:
+        void Write(std::string_view message, const LogColor& color) { Write({ message }, color); }
+
+        // Writes the concatenation of parts straight into the slot, so callers can log a
+        // prefix and a command without building a string first
+        void Write(std::initializer_list<std::string_view> parts, const LogColor& color) {
+            uint64_t index = write_pos_.fetch_add(1, std::memory_order_relaxed);
+            Slot& slot = slots_[index & (MAX_LOG_ENTRIES - 1)];
+
+            // Odd while the slot is being written for this index, even once it is complete
+            slot.sequence.store(index * 2 + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            FormatTimestamp(slot.entry.time_text);
+            slot.entry.color = color;
+            size_t length = 0;
+            for (std::string_view part : parts) {
+                // (std::min) stays a function call even where windows.h defines a min macro
+                const size_t copied = (std::min)(part.size(), MAX_LOG_MESSAGE - length);
+                memcpy(slot.entry.message + length, part.data(), copied);
+                length += copied;
+            }
+            slot.entry.length = (uint16_t)length;
+
+            slot.sequence.store(index * 2 + 2, std::memory_order_release);
+        }
+
+        // Number of entries ever written; entries [End() - MAX_LOG_ENTRIES, End()) are retained
+        uint64_t End() const { return write_pos_.load(std::memory_order_acquire); }
+
+        // Copies entry `index` into out. Returns false if it is still being written or has
+        // already been overwritten.
+        bool Read(uint64_t index, LogEntry& out) const {
+            const Slot& slot = slots_[index & (MAX_LOG_ENTRIES - 1)];
+            const uint64_t expected = index * 2 + 2;
+            if (slot.sequence.load(std::memory_order_acquire) != expected) return false;
+
+            memcpy(out.time_text, slot.entry.time_text, sizeof(out.time_text));
+            out.color = slot.entry.color;
+            out.length = (std::min<uint16_t>)(slot.entry.length, (uint16_t)MAX_LOG_MESSAGE);
+            memcpy(out.message, slot.entry.message, out.length);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return slot.sequence.load(std::memory_order_relaxed) == expected;
+        }
+
+    private:
+        struct Slot {
+            std::atomic<uint64_t> sequence{ 0 };
+            LogEntry entry;
+        };
+
+        // Formats the current wall-clock time, reusing the text while the second is unchanged
+        static void FormatTimestamp(char (&out)[12]);
+
+        alignas(64) std::atomic<uint64_t> write_pos_{ 0 };
+        Slot slots_[MAX_LOG_ENTRIES];
+    };
+
+}
@@ -0,0 +1,184 @@
+#include "loopback_transport.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace streamerbot {
+
+    class LoopbackTransport::LoopbackPoller final : public Poller {
+    public:
+        explicit LoopbackPoller(LoopbackTransport& transport) : transport_(transport) {}
+
+        bool Add(SocketHandle socket) override {
+            std::lock_guard<std::mutex> lock(transport_.mutex_);
+            if (!transport_.Find(socket)) return false;
+            write_interest_[socket] = false;
+            return true;
+        }
+
+        bool SetWriteInterest(SocketHandle socket, bool enabled) override {
+            std::lock_guard<std::mutex> lock(transport_.mutex_);
+            auto it = write_interest_.find(socket);
+            if (it == write_interest_.end()) return false;
+            it->second = enabled;
+            return true;
+        }
+
+        void Remove(SocketHandle socket) override {
+            std::lock_guard<std::mutex> lock(transport_.mutex_);
+            write_interest_.erase(socket);
+        }
+
+        int Wait(PollEvent* events, int max_events, int timeout_ms) override {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+            std::unique_lock<std::mutex> lock(transport_.mutex_);
+
+            while (true) {
+                int count = 0;
+                for (const auto& [socket, write_interest] : write_interest_) {
+                    if (count == max_events) break;
+
+                    PollEvent ev;
+                    ev.socket = socket;
+                    const Endpoint* endpoint = transport_.Find(socket);
+                    if (!endpoint) {
+                        ev.error = true;
+                    }
+                    else if (endpoint->listener) {
+                        ev.readable = !endpoint->backlog.empty();
+                    }
+                    else {
+                        ev.readable = !endpoint->inbound.empty() || endpoint->peer_closed;
+                        ev.writable = write_interest;
+                    }
+
+                    if (ev.readable || ev.writable || ev.error) {
+                        events[count++] = ev;
+                    }
+                }
+
+                if (count > 0 || woken_) {
+                    woken_ = false;
+                    return count;
+                }
+                if (transport_.changed_.wait_until(lock, deadline) == std::cv_status::timeout) return 0;
+            }
+        }
+
+        void Wake() override {
+            std::lock_guard<std::mutex> lock(transport_.mutex_);
+            woken_ = true;
+            transport_.changed_.notify_all();
+        }
+
+    private:
+        LoopbackTransport& transport_;
+        bool woken_ = false;                                      // Guarded by the transport mutex
+        std::unordered_map<SocketHandle, bool> write_interest_;   // Registered socket -> write interest
+    };
+
+    LoopbackTransport::Endpoint* LoopbackTransport::Find(SocketHandle socket) {
+        auto it = endpoints_.find(socket);
+        return it == endpoints_.end() ? nullptr : &it->second;
+    }
+
+    SocketHandle LoopbackTransport::Listen(int port, bool, std::string& error) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (listeners_.count(port)) {
+            error = "Bind failed on port " + std::to_string(port);
+            return INVALID_SOCKET_HANDLE;
+        }
+
+        SocketHandle handle = next_handle_++;
+        Endpoint& listener = endpoints_[handle];
+        listener.listener = true;
+        listener.port = port;
+        listeners_[port] = handle;
+        return handle;
+    }
+
+    SocketHandle LoopbackTransport::Connect(int port) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = listeners_.find(port);
+        if (it == listeners_.end()) return INVALID_SOCKET_HANDLE;
+
+        SocketHandle client = next_handle_++;
+        SocketHandle server = next_handle_++;
+        endpoints_[client].peer = server;
+        endpoints_[server].peer = client;
+        endpoints_[it->second].backlog.push_back(server);
+        changed_.notify_all();
+        return client;
+    }
+
+    IoResult LoopbackTransport::Accept(SocketHandle listener, SocketHandle& client, std::string& address) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Endpoint* endpoint = Find(listener);
+        if (!endpoint || !endpoint->listener) return IoResult{ IoStatus::Error, 0, -1 };
+        if (endpoint->backlog.empty()) return IoResult{ IoStatus::WouldBlock, 0, 0 };
+
+        client = endpoint->backlog.front();
+        endpoint->backlog.pop_front();
+        address = "loopback";
+        return IoResult();
+    }
+
+    IoResult LoopbackTransport::Recv(SocketHandle socket, char* buffer, size_t size) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Endpoint* endpoint = Find(socket);
+        if (!endpoint || endpoint->listener) return IoResult{ IoStatus::Error, 0, -1 };
+
+        if (endpoint->inbound.empty()) {
+            return IoResult{ endpoint->peer_closed ? IoStatus::Closed : IoStatus::WouldBlock, 0, 0 };
+        }
+        size_t count = std::min(size, endpoint->inbound.size());
+        memcpy(buffer, endpoint->inbound.data(), count);
+        endpoint->inbound.erase(0, count);
+        return IoResult{ IoStatus::Ok, count, 0 };
+    }
+
+    IoResult LoopbackTransport::Send(SocketHandle socket, const char* data, size_t size) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Endpoint* endpoint = Find(socket);
+        if (!endpoint || endpoint->listener) return IoResult{ IoStatus::Error, 0, -1 };
+
+        Endpoint* peer = endpoint->peer_closed ? nullptr : Find(endpoint->peer);
+        if (!peer) return IoResult{ IoStatus::Error, 0, -1 };
+
+        peer->inbound.append(data, size);
+        changed_.notify_all();
+        return IoResult{ IoStatus::Ok, size, 0 };
+    }
+
+    void LoopbackTransport::Close(SocketHandle socket) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        CloseLocked(socket);
+        changed_.notify_all();
+    }
+
+    void LoopbackTransport::CloseLocked(SocketHandle socket) {
+        auto it = endpoints_.find(socket);
+        if (it == endpoints_.end()) return;
+
+        if (it->second.listener) {
+            // Connections nobody accepted are refused
+            std::deque<SocketHandle> backlog = std::move(it->second.backlog);
+            listeners_.erase(it->second.port);
+            endpoints_.erase(it);
+            for (SocketHandle pending : backlog) {
+                CloseLocked(pending);
+            }
+            return;
+        }
+
+        if (Endpoint* peer = Find(it->second.peer)) {
+            peer->peer_closed = true;
+        }
+        endpoints_.erase(it);
+    }
+
+    std::unique_ptr<Poller> LoopbackTransport::CreatePoller() {
+        return std::make_unique<LoopbackPoller>(*this);
+    }
+
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "transport.hpp"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace streamerbot {
+
+    // In-process transport. Listen() registers a port in this object only and Connect() pairs
+    // a client endpoint with a server endpoint whose bytes travel through memory, so the
+    // server can be driven deterministically without a network stack. Sends never block;
+    // pollers wait on a condition variable that every state change and Wake() signals.
+    class LoopbackTransport final : public Transport {
+    public:
+        bool Startup(std::string&) override { return true; }
+        void Cleanup() override {}
+
+        SocketHandle Listen(int port, bool loopback_only, std::string& error) override;
+        IoResult Accept(SocketHandle listener, SocketHandle& client, std::string& address) override;
+        IoResult Recv(SocketHandle socket, char* buffer, size_t size) override;
+        IoResult Send(SocketHandle socket, const char* data, size_t size) override;
+        void Close(SocketHandle socket) override;
+        int LastError() const override { return 0; }
+
+        std::unique_ptr<Poller> CreatePoller() override;
+
+        // Connects to a port opened with Listen(). Returns the client end, or
+        // INVALID_SOCKET_HANDLE if nothing listens there.
+        SocketHandle Connect(int port);
+
+    private:
+        class LoopbackPoller;
+
+        struct Endpoint {
+            bool listener = false;
+            int port = 0;
+            std::deque<SocketHandle> backlog;           // Listener: server ends not yet accepted
+            SocketHandle peer = INVALID_SOCKET_HANDLE;  // Connection: the other end
+            std::string inbound;                        // Connection: bytes sent by the peer
+            bool peer_closed = false;
+        };
+
+        Endpoint* Find(SocketHandle socket);
+        void CloseLocked(SocketHandle socket);
+
+        std::mutex mutex_;
+        std::condition_variable changed_;
+        std::unordered_map<SocketHandle, Endpoint> endpoints_;
+        std::unordered_map<int, SocketHandle> listeners_;    // Port -> listener
+        SocketHandle next_handle_ = 1;
+    };
+
+}
@@ -0,0 +1,88 @@
+#include "metrics.hpp"
+#include <cinttypes>
+#include <cstdio>
+
+namespace streamerbot {
+
+    void MetricsWriter::Header(std::string_view name, std::string_view help, std::string_view type) {
+        buffer_ += "# HELP ";
+        buffer_ += name;
+        buffer_ += ' ';
+        buffer_ += help;
+        buffer_ += "\n# TYPE ";
+        buffer_ += name;
+        buffer_ += ' ';
+        buffer_ += type;
+        buffer_ += '\n';
+    }
+
+    void MetricsWriter::Sample(std::string_view name, std::string_view labels, const char* value) {
+        buffer_ += name;
+        if (!labels.empty()) {
+            buffer_ += '{';
+            buffer_ += labels;
+            buffer_ += '}';
+        }
+        buffer_ += ' ';
+        buffer_ += value;
+        buffer_ += '\n';
+    }
+
+    void MetricsWriter::Counter(std::string_view name, std::string_view help, uint64_t value) {
+        char text[32];
+        snprintf(text, sizeof(text), "%" PRIu64, value);
+        Header(name, help, "counter");
+        Sample(name, {}, text);
+    }
+
+    void MetricsWriter::Gauge(std::string_view name, std::string_view help, double value) {
+        char text[32];
+        snprintf(text, sizeof(text), "%.17g", value);
+        Header(name, help, "gauge");
+        Sample(name, {}, text);
+    }
+
+    void MetricsWriter::SummaryFamily(std::string_view name, std::string_view help) {
+        Header(name, help, "summary");
+    }
+
+    void MetricsWriter::SummarySeries(std::string_view name, std::string_view label, std::string_view label_value,
+        const LatencyHistogram& histogram) {
+        const LatencySummary summary = histogram.Summarize();
+        const struct {
+            const char* quantile;
+            uint64_t value_ns;
+        } quantiles[] = {
+            { "0.5", summary.p50_ns },
+            { "0.9", summary.p90_ns },
+            { "0.99", summary.p99_ns },
+        };
+
+        char labels[128];
+        char text[32];
+        for (const auto& q : quantiles) {
+            snprintf(labels, sizeof(labels), "%.*s=\"%.*s\",quantile=\"%s\"",
+                (int)label.size(), label.data(), (int)label_value.size(), label_value.data(), q.quantile);
+            snprintf(text, sizeof(text), "%.9g", (double)q.value_ns / 1e9);
+            Sample(name, labels, text);
+        }
+
+        snprintf(labels, sizeof(labels), "%.*s=\"%.*s\"", (int)label.size(), label.data(), (int)label_value.size(), label_value.data());
+        snprintf(text, sizeof(text), "%.9g", (double)histogram.SumNs() / 1e9);
+        buffer_ += name;
+        buffer_ += "_sum{";
+        buffer_ += labels;
+        buffer_ += "} ";
+        buffer_ += text;
+        buffer_ += '\n';
+
+        snprintf(text, sizeof(text), "%" PRIu64, summary.count);
+        buffer_ += name;
+        buffer_ += "_count{";
+        buffer_ += labels;
+        buffer_ += "} ";
+        buffer_ += text;
+        buffer_ += '\n';
+    }
+
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "latency_histogram.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace streamerbot {
+
+    // Writes metrics in the Prometheus text exposition format (version 0.0.4). The buffer is
+    // kept between scrapes, so serializing a page does not allocate once it has grown to size.
+    class MetricsWriter {
+    public:
+        void Begin() { buffer_.clear(); }
+        std::string_view Text() const { return buffer_; }
+
+        void Counter(std::string_view name, std::string_view help, uint64_t value);
+        void Gauge(std::string_view name, std::string_view help, double value);
+
+        // Starts a summary family; add one SummarySeries() per label value afterwards
+        void SummaryFamily(std::string_view name, std::string_view help);
+        // Writes p50/p90/p99, _sum and _count of a histogram in seconds
+        void SummarySeries(std::string_view name, std::string_view label, std::string_view label_value, const LatencyHistogram& histogram);
+
+    private:
+        void Header(std::string_view name, std::string_view help, std::string_view type);
+        void Sample(std::string_view name, std::string_view labels, const char* value);
+
+        std::string buffer_;
+    };
+
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace streamerbot {
+
+    // Bounded lock-free multi-producer/single-consumer ring. Producers claim a slot with a CAS
+    // on the enqueue position; each slot's sequence number publishes the value to the consumer.
+    template <typename T, size_t Capacity>
+    class MpscQueue {
+        static_assert((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+    public:
+        MpscQueue() {
+            for (size_t i = 0; i < Capacity; ++i) {
+                slots_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        bool TryPush(const T& value) {
+            size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+            while (true) {
+                Slot& slot = slots_[pos & (Capacity - 1)];
+                size_t seq = slot.sequence.load(std::memory_order_acquire);
+                intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+                if (diff == 0) {
+                    if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        slot.value = value;
+                        slot.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0) {
+                    return false; // Full
+                }
+                else {
+                    pos = enqueue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Pushes count values into consecutive slots, or nothing if they do not all fit. The
+        // first value is published last, so a consumer that has popped it can pop the rest
+        // without waiting.
+        bool TryPushBatch(const T* values, size_t count) {
+            if (count == 0) return true;
+            if (count > Capacity) return false;
+
+            size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+            while (true) {
+                Slot& first = slots_[pos & (Capacity - 1)];
+                intptr_t diff = (intptr_t)first.sequence.load(std::memory_order_acquire) - (intptr_t)pos;
+                if (diff == 0) {
+                    // Slots are freed in order, so the last slot being free means all of them are
+                    const size_t last_pos = pos + count - 1;
+                    Slot& last = slots_[last_pos & (Capacity - 1)];
+                    if ((intptr_t)last.sequence.load(std::memory_order_acquire) - (intptr_t)last_pos < 0) {
+                        return false; // Full
+                    }
+                    if (enqueue_pos_.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed)) {
+                        for (size_t i = count; i-- > 0;) {
+                            Slot& slot = slots_[(pos + i) & (Capacity - 1)];
+                            slot.value = values[i];
+                            slot.sequence.store(pos + i + 1, std::memory_order_release);
+                        }
+                        return true;
+                    }
+                }
+                else if (diff < 0) {
+                    return false; // Full
+                }
+                else {
+                    pos = enqueue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Consumer side; must only be called from one thread at a time
+        bool TryPop(T& value) {
+            Slot& slot = slots_[dequeue_pos_ & (Capacity - 1)];
+            size_t seq = slot.sequence.load(std::memory_order_acquire);
+            if ((intptr_t)seq - (intptr_t)(dequeue_pos_ + 1) < 0) {
+                return false; // Empty
+            }
+            value = slot.value;
+            slot.sequence.store(dequeue_pos_ + Capacity, std::memory_order_release);
+            ++dequeue_pos_;
+            return true;
+        }
+
+        size_t ApproxSize() const {
+            size_t head = enqueue_pos_.load(std::memory_order_relaxed);
+            size_t tail = dequeue_pos_shadow_.load(std::memory_order_relaxed);
+            return head >= tail ? head - tail : 0;
+        }
+
+        // Publishes the consumer position for ApproxSize(); called once per drain
+        void PublishConsumerPosition() { dequeue_pos_shadow_.store(dequeue_pos_, std::memory_order_relaxed); }
+
+    private:
+        struct Slot {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        alignas(64) std::atomic<size_t> enqueue_pos_{ 0 };
+        alignas(64) size_t dequeue_pos_ = 0;
+        std::atomic<size_t> dequeue_pos_shadow_{ 0 };
+        alignas(64) Slot slots_[Capacity];
+    };
+
+}
@@ -0,0 +1,284 @@
+#include "transport.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#else
+#include <poll.h>
+#endif
+
+namespace streamerbot {
+
+    namespace {
+#if defined(__linux__)
+        // epoll backend; Wake() signals an eventfd registered alongside the sockets
+        class EpollPoller final : public Poller {
+        public:
+            EpollPoller()
+                : epoll_fd_(epoll_create1(EPOLL_CLOEXEC)), wake_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+                epoll_event ev = {};
+                ev.events = EPOLLIN;
+                ev.data.fd = wake_fd_;
+                epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+            }
+            ~EpollPoller() override {
+                if (wake_fd_ >= 0) close(wake_fd_);
+                if (epoll_fd_ >= 0) close(epoll_fd_);
+            }
+
+            bool Add(SocketHandle socket) override {
+                epoll_event ev = {};
+                ev.events = EPOLLIN;
+                ev.data.fd = (int)socket;
+                return epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, (int)socket, &ev) == 0;
+            }
+
+            bool SetWriteInterest(SocketHandle socket, bool enabled) override {
+                epoll_event ev = {};
+                ev.events = enabled ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+                ev.data.fd = (int)socket;
+                return epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, (int)socket, &ev) == 0;
+            }
+
+            void Remove(SocketHandle socket) override {
+                epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, (int)socket, nullptr);
+            }
+
+            int Wait(PollEvent* events, int max_events, int timeout_ms) override {
+                epoll_event ready[64];
+                int n = epoll_wait(epoll_fd_, ready, std::min(max_events, 64), timeout_ms);
+                if (n < 0) {
+                    return errno == EINTR ? 0 : -1;
+                }
+
+                int count = 0;
+                for (int i = 0; i < n; ++i) {
+                    if (ready[i].data.fd == wake_fd_) {
+                        uint64_t value;
+                        ssize_t drained = read(wake_fd_, &value, sizeof(value));
+                        (void)drained;
+                        continue;
+                    }
+                    PollEvent& ev = events[count++];
+                    ev.socket = (SocketHandle)ready[i].data.fd;
+                    ev.readable = (ready[i].events & (EPOLLIN | EPOLLHUP)) != 0;
+                    ev.writable = (ready[i].events & EPOLLOUT) != 0;
+                    ev.error = (ready[i].events & EPOLLERR) != 0;
+                }
+                return count;
+            }
+
+            void Wake() override {
+                uint64_t one = 1;
+                ssize_t written = write(wake_fd_, &one, sizeof(one));
+                (void)written;
+            }
+
+        private:
+            int epoll_fd_;
+            int wake_fd_;
+        };
+#else
+        // poll() backend for platforms without epoll; Wake() writes to a self-pipe
+        class PosixPollPoller final : public Poller {
+        public:
+            PosixPollPoller() {
+                if (pipe(wake_pipe_) == 0) {
+                    for (int fd : wake_pipe_) {
+                        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+                        fcntl(fd, F_SETFD, FD_CLOEXEC);
+                    }
+                    pollfd wake = {};
+                    wake.fd = wake_pipe_[0];
+                    wake.events = POLLIN;
+                    fds_.push_back(wake);
+                }
+            }
+            ~PosixPollPoller() override {
+                for (int fd : wake_pipe_) {
+                    if (fd >= 0) close(fd);
+                }
+            }
+
+            bool Add(SocketHandle socket) override {
+                pollfd fd = {};
+                fd.fd = (int)socket;
+                fd.events = POLLIN;
+                fds_.push_back(fd);
+                return true;
+            }
+
+            bool SetWriteInterest(SocketHandle socket, bool enabled) override {
+                for (auto& fd : fds_) {
+                    if (fd.fd == (int)socket) {
+                        fd.events = enabled ? (POLLIN | POLLOUT) : POLLIN;
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            void Remove(SocketHandle socket) override {
+                for (size_t i = 0; i < fds_.size(); ++i) {
+                    if (fds_[i].fd == (int)socket) {
+                        fds_[i] = fds_.back();
+                        fds_.pop_back();
+                        return;
+                    }
+                }
+            }
+
+            int Wait(PollEvent* events, int max_events, int timeout_ms) override {
+                int ready = poll(fds_.data(), (nfds_t)fds_.size(), timeout_ms);
+                if (ready <= 0) {
+                    return (ready == 0 || errno == EINTR) ? 0 : -1;
+                }
+
+                int count = 0;
+                for (const auto& fd : fds_) {
+                    if (fd.revents == 0) continue;
+                    if (fd.fd == wake_pipe_[0]) {
+                        char drain[64];
+                        while (read(wake_pipe_[0], drain, sizeof(drain)) > 0) {}
+                        continue;
+                    }
+                    if (count == max_events) break;
+                    PollEvent& ev = events[count++];
+                    ev.socket = (SocketHandle)fd.fd;
+                    ev.readable = (fd.revents & (POLLIN | POLLHUP)) != 0;
+                    ev.writable = (fd.revents & POLLOUT) != 0;
+                    ev.error = (fd.revents & (POLLERR | POLLNVAL)) != 0;
+                }
+                return count;
+            }
+
+            void Wake() override {
+                char one = 1;
+                ssize_t written = write(wake_pipe_[1], &one, 1);
+                (void)written;
+            }
+
+        private:
+            std::vector<pollfd> fds_;
+            int wake_pipe_[2] = { -1, -1 };
+        };
+#endif
+
+        void SetNonBlocking(int fd) {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        }
+
+        IoResult SocketFailure() {
+            IoResult result;
+            result.error = errno;
+            result.status = (result.error == EAGAIN || result.error == EWOULDBLOCK || result.error == EINTR)
+                ? IoStatus::WouldBlock : IoStatus::Error;
+            return result;
+        }
+
+        class PosixTransport final : public Transport {
+        public:
+            bool Startup(std::string&) override { return true; }
+            void Cleanup() override {}
+
+            SocketHandle Listen(int port, bool loopback_only, std::string& error) override {
+                int listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+                if (listener < 0) {
+                    error = "Socket creation failed";
+                    return INVALID_SOCKET_HANDLE;
+                }
+                fcntl(listener, F_SETFD, FD_CLOEXEC);
+
+                int opt = 1;
+                setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+                SetNonBlocking(listener);
+
+                sockaddr_in server_addr = {};
+                server_addr.sin_family = AF_INET;
+                server_addr.sin_addr.s_addr = htonl(loopback_only ? INADDR_LOOPBACK : INADDR_ANY);
+                server_addr.sin_port = htons((uint16_t)port);
+
+                if (bind(listener, (sockaddr*)&server_addr, sizeof(server_addr)) != 0) {
+                    error = "Bind failed on port " + std::to_string(port);
+                    close(listener);
+                    return INVALID_SOCKET_HANDLE;
+                }
+                if (listen(listener, SOMAXCONN) != 0) {
+                    error = "Listen failed";
+                    close(listener);
+                    return INVALID_SOCKET_HANDLE;
+                }
+                return (SocketHandle)listener;
+            }
+
+            IoResult Accept(SocketHandle listener, SocketHandle& client, std::string& address) override {
+                sockaddr_in client_addr = {};
+                socklen_t client_len = sizeof(client_addr);
+                int client_fd = accept((int)listener, (sockaddr*)&client_addr, &client_len);
+                if (client_fd < 0) {
+                    IoResult result = SocketFailure();
+                    if (result.error == ECONNABORTED) result.status = IoStatus::WouldBlock;
+                    return result;
+                }
+
+                fcntl(client_fd, F_SETFD, FD_CLOEXEC);
+                SetNonBlocking(client_fd);
+                int nodelay = 1;
+                setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+                char addr_str[INET_ADDRSTRLEN];
+                inet_ntop(AF_INET, &client_addr.sin_addr, addr_str, INET_ADDRSTRLEN);
+                address = addr_str;
+                client = (SocketHandle)client_fd;
+                return IoResult();
+            }
+
+            IoResult Recv(SocketHandle socket, char* buffer, size_t size) override {
+                ssize_t received = recv((int)socket, buffer, size, 0);
+                if (received == 0) return IoResult{ IoStatus::Closed, 0, 0 };
+                if (received < 0) return SocketFailure();
+                return IoResult{ IoStatus::Ok, (size_t)received, 0 };
+            }
+
+            IoResult Send(SocketHandle socket, const char* data, size_t size) override {
+#if defined(MSG_NOSIGNAL)
+                ssize_t sent = send((int)socket, data, size, MSG_NOSIGNAL);
+#else
+                ssize_t sent = send((int)socket, data, size, 0);
+#endif
+                if (sent < 0) return SocketFailure();
+                return IoResult{ IoStatus::Ok, (size_t)sent, 0 };
+            }
+
+            void Close(SocketHandle socket) override {
+                close((int)socket);
+            }
+
+            int LastError() const override {
+                return errno;
+            }
+
+            std::unique_ptr<Poller> CreatePoller() override {
+#if defined(__linux__)
+                return std::make_unique<EpollPoller>();
+#else
+                return std::make_unique<PosixPollPoller>();
+#endif
+            }
+        };
+    }
+
+    std::unique_ptr<Transport> CreatePlatformTransport() {
+        return std::make_unique<PosixTransport>();
+    }
+
+}
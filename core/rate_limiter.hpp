@@ -0,0 +1,116 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace streamerbot {
+
+    constexpr size_t CLIENT_BACKLOG_LINES = 256;    // Lines a client may have waiting before new ones are dropped
+    constexpr uint32_t FAIR_QUEUE_QUANTUM = 8;      // Commands each waiting client may submit per round
+
+    // Token bucket refilled lazily from the monotonic clock: rate tokens per second, holding
+    // at most burst. A rate of zero disables the limit. (std::min)/(std::max) are parenthesized
+    // because the addon includes this after windows.h.
+    class TokenBucket {
+    public:
+        void Configure(double rate_per_second, double burst) {
+            rate_per_ns_ = rate_per_second > 0.0 ? rate_per_second * 1e-9 : 0.0;
+            burst_ = (std::max)(burst, 1.0);
+            tokens_ = last_ns_ == 0 ? burst_ : (std::min)(tokens_, burst_);   // A new bucket starts full
+        }
+
+        bool Unlimited() const { return rate_per_ns_ == 0.0; }
+        double Burst() const { return burst_; }
+
+        // Takes cost tokens if the bucket holds them. A cost above the burst is charged as the burst.
+        bool TryTake(double cost, int64_t now_ns) {
+            if (Unlimited()) return true;
+            Refill(now_ns);
+            cost = (std::min)(cost, burst_);
+            if (tokens_ < cost) return false;
+            tokens_ -= cost;
+            return true;
+        }
+
+        // Nanoseconds until TryTake(cost) can succeed
+        int64_t WaitNs(double cost, int64_t now_ns) {
+            if (Unlimited()) return 0;
+            Refill(now_ns);
+            const double missing = (std::min)(cost, burst_) - tokens_;
+            return missing <= 0.0 ? 0 : (int64_t)(missing / rate_per_ns_) + 1;
+        }
+
+    private:
+        void Refill(int64_t now_ns) {
+            if (now_ns > last_ns_) {
+                tokens_ = (std::min)(burst_, tokens_ + (double)(now_ns - last_ns_) * rate_per_ns_);
+                last_ns_ = now_ns;
+            }
+        }
+
+        double rate_per_ns_ = 0.0;
+        double burst_ = 1.0;
+        double tokens_ = 1.0;
+        int64_t last_ns_ = 0;
+    };
+
+    // Command lines a client has sent that are waiting for their turn, in arrival order. The
+    // text and index keep their capacity once drained, so a steady flow does not allocate.
+    class CommandBacklog {
+    public:
+        struct Line {
+            uint32_t offset;
+            uint32_t length;
+            int64_t received_ns;
+            uint32_t cost;              // Commands on the line: 1, or one per ';'-separated part
+            bool throttled;             // Has waited for tokens at least once
+        };
+
+        bool Push(std::string_view line, int64_t received_ns, uint32_t cost) {
+            if (Size() >= CLIENT_BACKLOG_LINES) return false;
+            lines_.push_back(Line{ (uint32_t)text_.size(), (uint32_t)line.size(), received_ns, cost, false });
+            text_.append(line.data(), line.size());
+            return true;
+        }
+
+        bool Empty() const { return head_ == lines_.size(); }
+        size_t Size() const { return lines_.size() - head_; }
+        Line& Front() { return lines_[head_]; }
+        std::string_view Text(const Line& line) const { return std::string_view(text_.data() + line.offset, line.length); }
+
+        void Pop() {
+            if (++head_ == lines_.size()) {
+                Clear();
+            }
+            else if (head_ >= CLIENT_BACKLOG_LINES) {
+                Compact();
+            }
+        }
+
+        void Clear() {
+            lines_.clear();
+            text_.clear();
+            head_ = 0;
+        }
+
+    private:
+        // Drops consumed lines from a backlog that never ran empty; amortized over the pops before it
+        void Compact() {
+            const uint32_t base = lines_[head_].offset;
+            text_.erase(0, base);
+            lines_.erase(lines_.begin(), lines_.begin() + (ptrdiff_t)head_);
+            for (Line& line : lines_) {
+                line.offset -= base;
+            }
+            head_ = 0;
+        }
+
+        std::vector<Line> lines_;
+        std::string text_;
+        size_t head_ = 0;
+    };
+
+}
@@ -0,0 +1,742 @@
+#include "server.hpp"
+#include "text.hpp"
+#include "websocket.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+
+namespace streamerbot {
+
+    bool Server::Open(int port) {
+        std::string error;
+        listener_ = transport_.Listen(port, false, error);
+        if (listener_ == INVALID_SOCKET_HANDLE) {
+            log_.Write(error, LogColor{ 1.0f, 0.0f, 0.0f, 1.0f });
+            return false;
+        }
+
+        port_ = port;
+        {
+            std::lock_guard<std::mutex> lock(poller_mutex_);
+            poller_ = transport_.CreatePoller();
+        }
+        if (!poller_->Add(listener_)) {
+            log_.Write("Failed to register listening socket", LogColor{ 1.0f, 0.0f, 0.0f, 1.0f });
+            Close();
+            return false;
+        }
+
+        log_.Write("Server listening on port " + std::to_string(port), LogColor{ 0.0f, 1.0f, 0.0f, 1.0f });
+        return true;
+    }
+
+    bool Server::OpenOperator(int port) {
+        std::string error;
+        operator_listener_ = transport_.Listen(port, false, error);
+        if (operator_listener_ == INVALID_SOCKET_HANDLE) {
+            log_.Write("Operator port: " + error, LogColor{ 1.0f, 0.0f, 0.0f, 1.0f });
+            return false;
+        }
+        if (!poller_->Add(operator_listener_)) {
+            log_.Write("Failed to register operator socket", LogColor{ 1.0f, 0.0f, 0.0f, 1.0f });
+            transport_.Close(operator_listener_);
+            operator_listener_ = INVALID_SOCKET_HANDLE;
+            return false;
+        }
+
+        operator_port_ = port;
+        log_.Write("Operator commands on port " + std::to_string(port) + " (high priority)", LogColor{ 0.0f, 1.0f, 0.0f, 1.0f });
+        return true;
+    }
+
+    void Server::CloseOperator() {
+        if (operator_listener_ == INVALID_SOCKET_HANDLE) return;
+
+        if (poller_) {
+            poller_->Remove(operator_listener_);
+        }
+        transport_.Close(operator_listener_);
+        operator_listener_ = INVALID_SOCKET_HANDLE;
+    }
+
+    bool Server::OpenMetrics(int port, std::function<void(MetricsWriter&)> append_metrics) {
+        std::string error;
+        metrics_listener_ = transport_.Listen(port, true, error);
+        if (metrics_listener_ == INVALID_SOCKET_HANDLE) {
+            log_.Write("Metrics endpoint: " + error, LogColor{ 1.0f, 0.0f, 0.0f, 1.0f });
+            return false;
+        }
+        if (!poller_->Add(metrics_listener_)) {
+            log_.Write("Failed to register metrics socket", LogColor{ 1.0f, 0.0f, 0.0f, 1.0f });
+            transport_.Close(metrics_listener_);
+            metrics_listener_ = INVALID_SOCKET_HANDLE;
+            return false;
+        }
+
+        metrics_port_ = port;
+        append_metrics_ = std::move(append_metrics);
+        log_.Write("Metrics available at http://127.0.0.1:" + std::to_string(port) + "/metrics", LogColor{ 0.0f, 1.0f, 0.0f, 1.0f });
+        return true;
+    }
+
+    void Server::CloseMetrics() {
+        if (metrics_listener_ == INVALID_SOCKET_HANDLE) return;
+
+        if (poller_) {
+            poller_->Remove(metrics_listener_);
+        }
+        transport_.Close(metrics_listener_);
+        metrics_listener_ = INVALID_SOCKET_HANDLE;
+        append_metrics_ = nullptr;
+    }
+
+    void Server::Wake() {
+        std::lock_guard<std::mutex> lock(poller_mutex_);
+        if (poller_) {
+            poller_->Wake();
+        }
+    }
+
+    bool Server::Run(const std::function<bool()>& keep_running) {
+        int schedule_wait_ms = -1;
+        while (keep_running()) {
+            // Block until the listener or a client is ready instead of sleeping between polls,
+            // or until a rate-limited client has tokens again
+            const int timeout_ms = schedule_wait_ms < 0 ? POLL_TIMEOUT_MS : std::min(schedule_wait_ms, POLL_TIMEOUT_MS);
+            int ready = poller_->Wait(events_, (int)(sizeof(events_) / sizeof(events_[0])), timeout_ms);
+            if (ready < 0) {
+                log_.Write("Poll error: " + std::to_string(transport_.LastError()), LogColor{ 1.0f, 0.0f, 0.0f, 1.0f });
+                return false;
+            }
+
+            for (int i = 0; i < ready; ++i) {
+                const PollEvent& ev = events_[i];
+
+                if (ev.socket == listener_ || ev.socket == operator_listener_ || ev.socket == metrics_listener_) {
+                    if (!AcceptClients(ev.socket)) return false;
+                    continue;
+                }
+
+                auto it = clients_.find(ev.socket);
+                if (it == clients_.end()) continue; // Closed earlier in this batch
+
+                bool keep = !ev.error;
+                if (keep && ev.writable) {
+                    keep = FlushClient(*it->second);
+                }
+                if (keep && ev.readable) {
+                    keep = ServiceClient(*it->second);
+                }
+                if (!keep) {
+                    CloseClient(ev.socket);
+                }
+            }
+
+            schedule_wait_ms = ScheduleCommands();
+            FlushServedClients();
+            DeliverReplies();
+        }
+        return true;
+    }
+
+    void Server::Close() {
+        while (!clients_.empty()) {
+            CloseClient(clients_.begin()->first);
+        }
+        CloseOperator();
+        CloseMetrics();
+        {
+            std::lock_guard<std::mutex> lock(poller_mutex_);
+            poller_.reset();
+        }
+
+        if (listener_ != INVALID_SOCKET_HANDLE) {
+            transport_.Close(listener_);
+            listener_ = INVALID_SOCKET_HANDLE;
+        }
+
+        clients_connected_ = 0;
+        std::lock_guard<std::mutex> lock(address_mutex_);
+        last_address_ = "None";
+    }
+
+    // Sends a one-line reply in the client's protocol
+    void Server::SendReply(ClientConnection& client, std::string_view reply) {
+        if (client.protocol == ClientProtocol::WebSocket) {
+            websocket::AppendFrame(client.pending_output, websocket::OP_TEXT, reply);
+        }
+        else {
+            client.pending_output.append(reply.data(), reply.size());
+            client.pending_output += '\n';
+        }
+    }
+
+    // Common command path for every protocol. With no other client waiting and tokens to
+    // spare, the line goes straight to the engine as a view into the receive buffer.
+    // Otherwise it is admitted to the client's backlog, from which ScheduleCommands()
+    // submits it. Lines that still find the backlog full are dropped.
+    void Server::HandleCommand(ClientConnection& client, std::string_view command, int64_t received_ns) {
+        const uint32_t cost = (uint32_t)std::min<size_t>(1 + (size_t)std::count(command.begin(), command.end(), ';'), MAX_BATCH_COMMANDS);
+        if (waiting_clients_.empty()) {
+            ConfigureBucket(client.bucket);
+            if (client.bucket.TryTake(cost, received_ns)) {
+                client.dropping = false;
+                SubmitCommand(client, command, received_ns);
+                StatsOf(client).submitted.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+
+        bool admitted = client.backlog.Push(command, received_ns, cost);
+        if (!admitted) {
+            // One read can carry more lines than the backlog holds; make room for whatever
+            // the rate limits allow before dropping anything
+            ScheduleCommands();
+            admitted = client.backlog.Push(command, received_ns, cost);
+        }
+        if (!admitted) {
+            commands_rate_limited_.fetch_add(1, std::memory_order_relaxed);
+            StatsOf(client).dropped.fetch_add(1, std::memory_order_relaxed);
+            if (!client.dropping) {
+                client.dropping = true;
+                log_.Write("Rate limited " + client.address + ": backlog full, dropping commands", LogColor{ 1.0f, 0.5f, 0.0f, 1.0f });
+            }
+            SendReply(client, "ERROR rate limited");
+            return;
+        }
+
+        client.dropping = false;
+        if (!client.waiting) {
+            client.waiting = true;
+            waiting_clients_.push_back(&client);
+        }
+    }
+
+    void Server::SubmitCommand(ClientConnection& client, std::string_view command, int64_t received_ns) {
+        log_.Write({ "Received: ", command }, LogColor{ 0.8f, 0.8f, 1.0f, 1.0f });
+        CommandResult result = commands_.Submit(command, received_ns, client.source);
+
+        // Send acknowledgment, unless the render thread answers once it has run the command
+        // or the command joined a batch that is acknowledged at COMMIT
+        if (result != CommandResult::ReplyPending && result != CommandResult::Staged) {
+            SendReply(client, CommandResultReply(result));
+        }
+    }
+
+    // Deficit round robin between clients with a backlog. Every round gives each of them
+    // FAIR_QUEUE_QUANTUM commands of credit, and a line is submitted once its client has the
+    // credit and its token bucket the tokens, so a flooding client only ever gets its share.
+    // Runs rounds until every backlog is empty or waiting for tokens. Returns the milliseconds
+    // until a waiting client has tokens again, or -1 if none is waiting.
+    int Server::ScheduleCommands() {
+        if (waiting_clients_.empty()) return -1;
+
+        const int64_t now_ns = MonotonicNs();
+        int64_t wait_ns = -1;
+        for (ClientConnection* client : waiting_clients_) {
+            ConfigureBucket(client->bucket);
+        }
+
+        bool progress = true;
+        while (progress) {
+            progress = false;
+            for (ClientConnection* client : waiting_clients_) {
+                if (client->backlog.Empty() || client->closing) continue;
+
+                ClientStatsSlot& stats = StatsOf(*client);
+                client->deficit = std::min(client->deficit + FAIR_QUEUE_QUANTUM, FAIR_QUEUE_QUANTUM + (uint32_t)MAX_BATCH_COMMANDS);
+                bool served = false;
+                while (!client->backlog.Empty()) {
+                    CommandBacklog::Line& line = client->backlog.Front();
+                    if (line.cost > client->deficit) {
+                        // A long ';' batch collects credit over the next rounds
+                        progress = true;
+                        break;
+                    }
+                    if (!client->bucket.TryTake(line.cost, now_ns)) {
+                        if (!line.throttled) {
+                            line.throttled = true;
+                            commands_throttled_.fetch_add(1, std::memory_order_relaxed);
+                            stats.throttled.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        const int64_t wait = client->bucket.WaitNs(line.cost, now_ns);
+                        wait_ns = wait_ns < 0 ? wait : std::min(wait_ns, wait);
+                        break;
+                    }
+
+                    client->deficit -= line.cost;
+                    SubmitCommand(*client, client->backlog.Text(line), line.received_ns);
+                    client->backlog.Pop();
+                    stats.submitted.fetch_add(1, std::memory_order_relaxed);
+                    served = progress = true;
+                }
+                if (served && std::find(served_clients_.begin(), served_clients_.end(), client) == served_clients_.end()) {
+                    served_clients_.push_back(client);
+                }
+            }
+        }
+
+        // Clients whose backlog ran empty leave the rotation and lose their unused credit
+        size_t kept = 0;
+        for (ClientConnection* client : waiting_clients_) {
+            StatsOf(*client).backlog.store((uint32_t)client->backlog.Size(), std::memory_order_relaxed);
+            if (client->backlog.Empty() || client->closing) {
+                client->backlog.Clear();
+                client->waiting = false;
+                client->deficit = 0;
+                continue;
+            }
+            waiting_clients_[kept++] = client;
+        }
+        waiting_clients_.resize(kept);
+
+        if (wait_ns < 0) return -1;
+        return (int)std::min<int64_t>(wait_ns / 1000000 + 1, POLL_TIMEOUT_MS);
+    }
+
+    // Applies the current rate limit to a client's bucket
+    void Server::ConfigureBucket(TokenBucket& bucket) const {
+        const double rate = rate_limit_.load(std::memory_order_relaxed);
+        const double burst = rate_burst_.load(std::memory_order_relaxed);
+        bucket.Configure(rate, burst > 0.0 ? burst : rate);
+    }
+
+    // Sends the replies of the commands ScheduleCommands() submitted
+    void Server::FlushServedClients() {
+        while (!served_clients_.empty()) {
+            ClientConnection* client = served_clients_.back();
+            served_clients_.pop_back();
+            if (!FlushClient(*client)) {
+                CloseClient(client->socket);
+            }
+        }
+    }
+
+    // Handles every newline-separated command in a WebSocket text message
+    void Server::HandleWebSocketText(ClientConnection& client, std::string_view text, int64_t received_ns) {
+        while (!text.empty()) {
+            size_t nl = text.find('\n');
+            std::string_view line = text.substr(0, nl);
+            text = (nl == std::string_view::npos) ? std::string_view() : text.substr(nl + 1);
+
+            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+            if (!line.empty()) {
+                HandleCommand(client, line, received_ns);
+            }
+        }
+    }
+
+    // Decodes every complete frame in the connection buffer. Payloads are unmasked in place
+    // and handed to the command path as views; only fragmented messages are copied.
+    void Server::ServiceWebSocket(ClientConnection& client, int64_t received_ns) {
+        uint8_t* data = (uint8_t*)client.framer.Data();
+        size_t size = client.framer.Size();
+        size_t pos = 0;
+
+        while (!client.closing) {
+            websocket::FrameHeader frame;
+            if (!websocket::ParseFrameHeader(data + pos, size - pos, frame)) break;
+
+            if (!frame.masked) {
+                websocket::AppendClose(client.pending_output, websocket::CLOSE_PROTOCOL_ERROR);
+                client.closing = true;
+                break;
+            }
+            // Control frames are short and never fragmented
+            if ((frame.opcode & 0x8) != 0 && (!frame.fin || frame.payload_size > websocket::MAX_CONTROL_PAYLOAD)) {
+                websocket::AppendClose(client.pending_output, websocket::CLOSE_PROTOCOL_ERROR);
+                client.closing = true;
+                break;
+            }
+            // Continuations only follow an unfinished message, and a new message waits until
+            // that one has finished
+            const bool starts_message = frame.opcode == websocket::OP_TEXT || frame.opcode == websocket::OP_BINARY;
+            if ((starts_message && client.ws_fragmented) || (frame.opcode == websocket::OP_CONTINUATION && !client.ws_fragmented)) {
+                websocket::AppendClose(client.pending_output, websocket::CLOSE_PROTOCOL_ERROR);
+                client.closing = true;
+                break;
+            }
+            if (frame.payload_size > websocket::MAX_MESSAGE_SIZE) {
+                websocket::AppendClose(client.pending_output, websocket::CLOSE_TOO_BIG);
+                client.closing = true;
+                break;
+            }
+            if (size - pos < frame.header_size + frame.payload_size) break; // Wait for the rest of the frame
+
+            uint8_t* payload = data + pos + frame.header_size;
+            size_t payload_size = (size_t)frame.payload_size;
+            websocket::Unmask(payload, payload_size, frame.mask);
+            std::string_view text((const char*)payload, payload_size);
+            pos += frame.header_size + payload_size;
+
+            switch (frame.opcode) {
+            case websocket::OP_TEXT:
+                if (!frame.fin) {
+                    client.ws_message.assign(text.data(), text.size());
+                    client.ws_fragmented = true;
+                }
+                else if (!websocket::IsValidUtf8(text)) {
+                    websocket::AppendClose(client.pending_output, websocket::CLOSE_INVALID_PAYLOAD);
+                    client.closing = true;
+                }
+                else {
+                    HandleWebSocketText(client, text, received_ns);
+                }
+                break;
+            case websocket::OP_CONTINUATION:
+                if (client.ws_message.size() + text.size() > websocket::MAX_MESSAGE_SIZE) {
+                    websocket::AppendClose(client.pending_output, websocket::CLOSE_TOO_BIG);
+                    client.closing = true;
+                    break;
+                }
+                client.ws_message.append(text.data(), text.size());
+                if (frame.fin) {
+                    // Fragments may split a code point, so the message is checked whole
+                    if (!websocket::IsValidUtf8(client.ws_message)) {
+                        websocket::AppendClose(client.pending_output, websocket::CLOSE_INVALID_PAYLOAD);
+                        client.closing = true;
+                        break;
+                    }
+                    HandleWebSocketText(client, client.ws_message, received_ns);
+                    client.ws_message.clear();
+                    client.ws_fragmented = false;
+                }
+                break;
+            case websocket::OP_PING:
+                websocket::AppendFrame(client.pending_output, websocket::OP_PONG, text);
+                break;
+            case websocket::OP_PONG:
+                break;
+            case websocket::OP_CLOSE:
+                websocket::AppendFrame(client.pending_output, websocket::OP_CLOSE, text.substr(0, 2));
+                client.closing = true;
+                break;
+            case websocket::OP_BINARY:
+            default:
+                websocket::AppendClose(client.pending_output, websocket::CLOSE_UNSUPPORTED_DATA);
+                client.closing = true;
+                break;
+            }
+        }
+
+        client.framer.Consume(client.closing ? size : pos);
+    }
+
+    // Decides between raw TCP and a WebSocket upgrade from the first request line.
+    // Returns false while more bytes are needed.
+    bool Server::DetectProtocol(ClientConnection& client) {
+        std::string_view buffered(client.framer.Data(), client.framer.Size());
+        const std::string_view get = "GET ";
+
+        if (buffered.substr(0, get.size()) != get.substr(0, std::min(get.size(), buffered.size()))) {
+            client.protocol = ClientProtocol::Line;
+            return true;
+        }
+
+        size_t line_end = buffered.find('\n');
+        if (line_end == std::string_view::npos) {
+            if (buffered.size() > BUFFER_SIZE) {
+                client.protocol = ClientProtocol::Line;
+                return true;
+            }
+            return false;
+        }
+
+        // "GET / HTTP/1.1" is an upgrade request, anything else is a line command
+        if (buffered.substr(0, line_end).find(" HTTP/1.") == std::string_view::npos) {
+            client.protocol = ClientProtocol::Line;
+            return true;
+        }
+
+        size_t header_end = buffered.find("\r\n\r\n");
+        if (header_end == std::string_view::npos) {
+            if (client.framer.WriteCapacity() == 0) {
+                client.pending_output += "HTTP/1.1 431 Request Header Fields Too Large\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+                client.closing = true;
+            }
+            return false;
+        }
+
+        if (websocket::Handshake(buffered.substr(0, header_end + 2), client.pending_output)) {
+            client.protocol = ClientProtocol::WebSocket;
+            log_.Write("WebSocket client upgraded: " + client.address, LogColor{ 0.0f, 1.0f, 1.0f, 1.0f });
+        }
+        else {
+            client.closing = true;
+        }
+        client.framer.Consume(header_end + 4);
+        return !client.closing;
+    }
+
+    // Sends as much of the connection's pending output as the socket accepts right now.
+    // Returns false if the connection failed and should be closed.
+    bool Server::FlushClient(ClientConnection& client) {
+        while (!client.pending_output.empty()) {
+            IoResult sent = transport_.Send(client.socket, client.pending_output.data(), client.pending_output.size());
+            if (sent.status == IoStatus::Ok && sent.bytes > 0) {
+                client.pending_output.erase(0, sent.bytes);
+                continue;
+            }
+            if (sent.status == IoStatus::WouldBlock) {
+                poller_->SetWriteInterest(client.socket, true);
+                return true;
+            }
+            return false;
+        }
+        poller_->SetWriteInterest(client.socket, false);
+        return !client.closing;
+    }
+
+    // Sends replies produced by the render thread to the clients that asked. Replies for
+    // clients that have disconnected since are dropped.
+    void Server::DeliverReplies() {
+        CommandReply reply;
+        while (commands_.TryPopReply(reply)) {
+            auto it = std::find_if(clients_.begin(), clients_.end(), [&](const auto& entry) {
+                return entry.second->source.client_id == reply.client_id;
+                });
+            if (it == clients_.end()) continue;
+
+            SendReply(*it->second, reply.Text());
+            if (!FlushClient(*it->second)) {
+                CloseClient(it->first);
+            }
+        }
+    }
+
+    // Reads whatever is available from a client and processes it.
+    // Returns false if the client disconnected or failed.
+    bool Server::ServiceClient(ClientConnection& client) {
+        IoResult received = transport_.Recv(client.socket, client.framer.WritePtr(), client.framer.WriteCapacity());
+        const int64_t received_ns = MonotonicNs();
+
+        switch (received.status) {
+        case IoStatus::Ok:
+            break;
+        case IoStatus::WouldBlock:
+            return true;
+        case IoStatus::Closed:
+            // Client disconnected gracefully
+            return false;
+        case IoStatus::Error:
+            log_.Write("Socket error: " + std::to_string(received.error), LogColor{ 1.0f, 0.5f, 0.0f, 1.0f });
+            return false;
+        }
+
+        client.framer.Append(received.bytes);
+
+        if (client.protocol == ClientProtocol::Metrics) {
+            ServiceMetrics(client);
+            return FlushClient(client);
+        }
+
+        if (client.protocol == ClientProtocol::Detecting && !DetectProtocol(client)) {
+            return FlushClient(client);
+        }
+
+        if (client.protocol == ClientProtocol::WebSocket) {
+            ServiceWebSocket(client, received_ns);
+        }
+        else {
+            bool framed = client.framer.ExtractLines([&](std::string_view command) {
+                HandleCommand(client, command, received_ns);
+                });
+
+            if (!framed) {
+                log_.Write("Dropped command longer than " + std::to_string(BUFFER_SIZE) + " bytes from " + client.address,
+                    LogColor{ 1.0f, 0.5f, 0.0f, 1.0f });
+                SendReply(client, "ERROR command too long");
+            }
+        }
+
+        return FlushClient(client);
+    }
+
+    // Answers one HTTP request on the metrics port, then closes the connection
+    void Server::ServiceMetrics(ClientConnection& client) {
+        std::string_view buffered(client.framer.Data(), client.framer.Size());
+        size_t header_end = buffered.find("\r\n\r\n");
+        if (header_end == std::string_view::npos) {
+            if (client.framer.WriteCapacity() == 0) {
+                client.pending_output += "HTTP/1.1 431 Request Header Fields Too Large\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+                client.closing = true;
+            }
+            return;
+        }
+
+        std::string_view request_line = buffered.substr(0, buffered.find("\r\n"));
+        std::string_view path = request_line.substr(std::min<size_t>(4, request_line.size()));
+        path = path.substr(0, path.find_first_of(" ?"));
+
+        if (request_line.substr(0, 4) != "GET ") {
+            client.pending_output += "HTTP/1.1 405 Method Not Allowed\r\nAllow: GET\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        }
+        else if (path != "/metrics") {
+            client.pending_output += "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        }
+        else {
+            WriteMetrics();
+            std::string_view body = metrics_.Text();
+            char header[160];
+            int header_size = snprintf(header, sizeof(header),
+                "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+                body.size());
+            client.pending_output.reserve((size_t)header_size + body.size());
+            client.pending_output.append(header, (size_t)header_size);
+            client.pending_output.append(body.data(), body.size());
+        }
+
+        client.framer.Consume(client.framer.Size());
+        client.closing = true;
+    }
+
+    std::vector<ClientStats> Server::ClientStatistics() const {
+        std::vector<ClientStats> statistics;
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        for (const ClientStatsSlot& slot : client_stats_) {
+            const uint32_t client_id = slot.client_id.load(std::memory_order_relaxed);
+            if (client_id == 0) continue;
+
+            ClientStats stats;
+            stats.client_id = client_id;
+            stats.address = slot.address;
+            stats.submitted = slot.submitted.load(std::memory_order_relaxed);
+            stats.throttled = slot.throttled.load(std::memory_order_relaxed);
+            stats.dropped = slot.dropped.load(std::memory_order_relaxed);
+            stats.backlog = slot.backlog.load(std::memory_order_relaxed);
+            statistics.push_back(std::move(stats));
+        }
+        return statistics;
+    }
+
+    // Builds the metrics page from atomics only, so a scrape never waits on the render thread
+    void Server::WriteMetrics() {
+        metrics_.Begin();
+        metrics_.Counter("streamerbot_commands_received_total", "Commands received from clients.", (uint64_t)commands_.CommandsReceived());
+        metrics_.Counter("streamerbot_commands_dropped_total", "Commands dropped because the queue was full.", (uint64_t)commands_.CommandsDropped());
+        metrics_.Counter("streamerbot_commands_applied_total", "Commands applied on the render thread.", (uint64_t)commands_.CommandsApplied());
+        metrics_.Counter("streamerbot_commands_coalesced_total", "Technique commands folded into another command's runtime call.", (uint64_t)commands_.CommandsCoalesced());
+        metrics_.Counter("streamerbot_commands_throttled_total", "Commands that waited for their client's rate limit.", commands_throttled_.load());
+        metrics_.Counter("streamerbot_commands_rate_limited_total", "Commands dropped because their client's backlog was full.", commands_rate_limited_.load());
+        metrics_.Counter("streamerbot_parse_errors_total", "Command lines that could not be parsed.", (uint64_t)commands_.ParseErrors());
+        metrics_.Gauge("streamerbot_command_queue_depth", "Commands waiting for the render thread.", (double)commands_.Queued());
+        metrics_.Gauge("streamerbot_high_priority_queue_depth", "High priority commands waiting for the render thread.",
+            (double)commands_.Queued(CommandPriority::High));
+        metrics_.Counter("streamerbot_frames_presented_total", "Frames presented since the addon loaded.", commands_.Frames().Frame());
+        metrics_.Gauge("streamerbot_active_tweens", "Uniform tweens currently animating.", (double)commands_.ActiveTweens());
+        metrics_.Gauge("streamerbot_active_leases", "ENABLE ... FOR leases that have not expired.", (double)commands_.ActiveLeases());
+        metrics_.Gauge("streamerbot_scheduled_commands", "AT commands waiting for their frame or time.", (double)commands_.ScheduledCommands());
+        metrics_.Gauge("streamerbot_clients_connected", "Command clients currently connected.", (double)clients_connected_.load());
+        metrics_.Counter("streamerbot_connections_accepted_total", "Command connections accepted.", connections_accepted_.load());
+        metrics_.Counter("streamerbot_connections_rejected_total", "Command connections rejected at the client limit.", connections_rejected_.load());
+
+        metrics_.SummaryFamily("streamerbot_command_latency_seconds", "Command latency per pipeline stage.");
+        for (size_t i = 0; i < (size_t)LatencyStage::Count; ++i) {
+            const LatencyStage stage = (LatencyStage)i;
+            char stage_name[16] = {};
+            std::string_view name = LatencyStageName(stage);
+            std::transform(name.begin(), name.begin() + std::min(name.size(), sizeof(stage_name) - 1), stage_name, FoldAscii);
+            metrics_.SummarySeries("streamerbot_command_latency_seconds", "stage", stage_name, commands_.Latency(stage));
+        }
+
+        if (append_metrics_) {
+            append_metrics_(metrics_);
+        }
+    }
+
+    // Accepts every pending connection on a listening socket. Returns false if the
+    // listener failed.
+    bool Server::AcceptClients(SocketHandle listener) {
+        while (true) {
+            SocketHandle client_socket = INVALID_SOCKET_HANDLE;
+            std::string address;
+            IoResult accepted = transport_.Accept(listener, client_socket, address);
+
+            if (accepted.status == IoStatus::WouldBlock) {
+                return true;
+            }
+            if (accepted.status != IoStatus::Ok) {
+                log_.Write("Accept error: " + std::to_string(accepted.error), LogColor{ 1.0f, 0.0f, 0.0f, 1.0f });
+                return false;
+            }
+
+            if (clients_.size() >= MAX_CLIENTS) {
+                connections_rejected_++;
+                log_.Write("Rejected client: connection limit reached", LogColor{ 1.0f, 0.5f, 0.0f, 1.0f });
+                transport_.Close(client_socket);
+                continue;
+            }
+
+            if (!poller_->Add(client_socket)) {
+                transport_.Close(client_socket);
+                continue;
+            }
+
+            auto client = std::make_unique<ClientConnection>();
+            client->socket = client_socket;
+            client->source.client_id = next_client_id_++;
+            client->source.priority = listener == operator_listener_ ? CommandPriority::High : CommandPriority::Low;
+            client->address = std::move(address);
+
+            if (listener == metrics_listener_) {
+                // Scrapes are not command clients and are not logged
+                client->protocol = ClientProtocol::Metrics;
+                clients_.emplace(client_socket, std::move(client));
+                continue;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(address_mutex_);
+                last_address_ = client->address;
+            }
+            {
+                std::lock_guard<std::mutex> lock(stats_mutex_);
+                for (size_t slot = 0; slot < MAX_CLIENTS; ++slot) {
+                    ClientStatsSlot& stats = client_stats_[slot];
+                    if (stats.client_id.load(std::memory_order_relaxed) != 0) continue;
+                    stats.submitted.store(0, std::memory_order_relaxed);
+                    stats.throttled.store(0, std::memory_order_relaxed);
+                    stats.dropped.store(0, std::memory_order_relaxed);
+                    stats.backlog.store(0, std::memory_order_relaxed);
+                    stats.address = client->address;
+                    stats.client_id.store(client->source.client_id, std::memory_order_relaxed);
+                    client->stats_slot = slot;
+                    break;
+                }
+            }
+            // There are as many slots as clients, so every command client gets one
+            assert(client->stats_slot < MAX_CLIENTS);
+            clients_connected_++;
+            connections_accepted_++;
+            log_.Write(std::string(listener == operator_listener_ ? "Operator client" : "Client") + " connected from " + client->address,
+                LogColor{ 0.0f, 1.0f, 1.0f, 1.0f });
+            clients_.emplace(client_socket, std::move(client));
+        }
+    }
+
+    void Server::CloseClient(SocketHandle socket) {
+        auto it = clients_.find(socket);
+        if (it == clients_.end()) return;
+
+        poller_->Remove(socket);
+        transport_.Close(socket);
+        if (it->second->protocol == ClientProtocol::Metrics) {
+            clients_.erase(it);
+            return;
+        }
+        ClientConnection& client = *it->second;
+        if (client.waiting) {
+            waiting_clients_.erase(std::find(waiting_clients_.begin(), waiting_clients_.end(), &client));
+        }
+        served_clients_.erase(std::remove(served_clients_.begin(), served_clients_.end(), &client), served_clients_.end());
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            StatsOf(client).client_id.store(0, std::memory_order_relaxed);
+            StatsOf(client).address.clear();
+        }
+        log_.Write("Client disconnected: " + client.address, LogColor{ 1.0f, 0.5f, 0.0f, 1.0f });
+        clients_.erase(it);
+        clients_connected_--;
+    }
+
+}
@@ -0,0 +1,184 @@
+#pragma once
+#include "command_engine.hpp"
+#include "line_framer.hpp"
+#include "log_ring.hpp"
+#include "metrics.hpp"
+#include "rate_limiter.hpp"
+#include "transport.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace streamerbot {
+
+    constexpr size_t MAX_CLIENTS = 64;
+    constexpr int POLL_TIMEOUT_MS = 1000;        // Backstop for re-checking the run flags; stop requests call Wake()
+
+    // Wire protocol spoken by a client, decided from its first bytes
+    enum class ClientProtocol {
+        Detecting,
+        Line,        // Raw TCP, one command per line
+        WebSocket,   // RFC 6455 after an HTTP upgrade on the same port
+        Metrics,     // HTTP scrape on the metrics port
+    };
+
+    // Per-client connection state owned by the server thread
+    struct ClientConnection {
+        SocketHandle socket = INVALID_SOCKET_HANDLE;
+        std::string address;
+        std::string pending_output;   // Bytes the socket could not take yet
+        LineFramer framer;
+        ClientProtocol protocol = ClientProtocol::Detecting;
+        std::string ws_message;       // Reassembly buffer for fragmented WebSocket messages
+        bool ws_fragmented = false;   // A fragmented message is open: only continuation and control frames may follow
+        CommandSource source;         // Reply routing id, never reused, and the BEGIN/COMMIT batch
+        bool closing = false;         // Close once pending_output has been flushed
+
+        // Admission: lines that cannot go straight to the engine wait in the backlog until the
+        // client's token bucket and its turn in the deficit round robin between clients let
+        // them through
+        CommandBacklog backlog;
+        TokenBucket bucket;
+        uint32_t deficit = 0;
+        bool waiting = false;         // Listed in Server::waiting_clients_
+        bool dropping = false;        // Dropping lines since the backlog filled; logged once per episode
+        size_t stats_slot = SIZE_MAX;
+    };
+
+    // Per-client admission counters, readable from any thread
+    struct ClientStats {
+        uint32_t client_id = 0;
+        std::string address;
+        uint64_t submitted = 0;       // Lines handed to the command engine
+        uint64_t throttled = 0;       // Lines that had to wait for tokens
+        uint64_t dropped = 0;         // Lines rejected because the backlog was full
+        uint32_t backlog = 0;
+    };
+
+    // Command server. One thread runs the readiness loop over the listening socket and every
+    // client, frames raw TCP and WebSocket input and hands each command to the engine.
+    // The listener and client connections belong to the Server, not to a thread: when Run()
+    // returns they stay open, and a later Run(), possibly on another thread, picks them up
+    // again. Only one thread may use the server at a time; the status getters are safe
+    // from any thread.
+    class Server {
+    public:
+        Server(Transport& transport, CommandEngine& commands, LogRing& log)
+            : transport_(transport), commands_(commands), log_(log) {
+            commands_.SetReplyNotifier([this] { Wake(); });
+        }
+        ~Server() { Close(); }
+
+        bool Open(int port);
+        bool IsOpen() const { return listener_ != INVALID_SOCKET_HANDLE; }
+        int Port() const { return port_; }
+        // Also serves GET /metrics on 127.0.0.1:port. append_metrics adds the embedder's own
+        // metrics to every page; like the rest of the page it must only read atomics.
+        bool OpenMetrics(int port, std::function<void(MetricsWriter&)> append_metrics);
+        void CloseMetrics();
+        bool MetricsOpen() const { return metrics_listener_ != INVALID_SOCKET_HANDLE; }
+        int MetricsPort() const { return metrics_port_; }
+        // Also accepts command clients on an operator port. Their commands use the high
+        // priority lane, ahead of the audience commands from the main port.
+        bool OpenOperator(int port);
+        void CloseOperator();
+        bool OperatorOpen() const { return operator_listener_ != INVALID_SOCKET_HANDLE; }
+        int OperatorPort() const { return operator_port_; }
+        // Serves clients until keep_running() returns false or the server fails. Returns
+        // false on failure.
+        bool Run(const std::function<bool()>& keep_running);
+        // Closes every client and every listener
+        void Close();
+        // Interrupts the wait in Run() so that keep_running() is checked again right away.
+        // Safe to call from any thread.
+        void Wake();
+
+        // Limits each client to rate commands per second, with bursts of up to burst. A rate
+        // of zero removes the limit. Safe to call from any thread; applies right away.
+        void SetRateLimit(double rate_per_second, double burst) {
+            rate_limit_.store(rate_per_second, std::memory_order_relaxed);
+            rate_burst_.store(burst, std::memory_order_relaxed);
+        }
+        // Counters of every connected command client
+        std::vector<ClientStats> ClientStatistics() const;
+        uint64_t CommandsThrottled() const { return commands_throttled_.load(std::memory_order_relaxed); }
+        uint64_t CommandsRateLimited() const { return commands_rate_limited_.load(std::memory_order_relaxed); }
+
+        int ClientsConnected() const { return clients_connected_.load(); }
+        std::string LastClientAddress() const {
+            std::lock_guard<std::mutex> lock(address_mutex_);
+            return last_address_;
+        }
+
+    private:
+        // Slot in the client statistics table. The counters are written by the server thread
+        // only; the address is guarded by stats_mutex_.
+        struct ClientStatsSlot {
+            std::atomic<uint32_t> client_id{ 0 };   // 0 while the slot is free
+            std::atomic<uint64_t> submitted{ 0 };
+            std::atomic<uint64_t> throttled{ 0 };
+            std::atomic<uint64_t> dropped{ 0 };
+            std::atomic<uint32_t> backlog{ 0 };
+            std::string address;
+        };
+
+        // Statistics slot of a command client. Metrics clients have none.
+        ClientStatsSlot& StatsOf(const ClientConnection& client) { return client_stats_[client.stats_slot]; }
+        void SendReply(ClientConnection& client, std::string_view reply);
+        void HandleCommand(ClientConnection& client, std::string_view command, int64_t received_ns);
+        void SubmitCommand(ClientConnection& client, std::string_view command, int64_t received_ns);
+        int ScheduleCommands();
+        void ConfigureBucket(TokenBucket& bucket) const;
+        void FlushServedClients();
+        void HandleWebSocketText(ClientConnection& client, std::string_view text, int64_t received_ns);
+        void ServiceWebSocket(ClientConnection& client, int64_t received_ns);
+        bool DetectProtocol(ClientConnection& client);
+        bool FlushClient(ClientConnection& client);
+        void DeliverReplies();
+        bool ServiceClient(ClientConnection& client);
+        void ServiceMetrics(ClientConnection& client);
+        void WriteMetrics();
+        bool AcceptClients(SocketHandle listener);
+        void CloseClient(SocketHandle socket);
+
+        Transport& transport_;
+        CommandEngine& commands_;
+        LogRing& log_;
+
+        SocketHandle listener_ = INVALID_SOCKET_HANDLE;
+        int port_ = 0;
+        std::unique_ptr<Poller> poller_;
+        std::mutex poller_mutex_;                      // Guards poller_ against Wake() while it is created or destroyed
+        std::unordered_map<SocketHandle, std::unique_ptr<ClientConnection>> clients_;
+        PollEvent events_[MAX_CLIENTS + 3];            // Clients, listeners and the wake-up source
+        uint32_t next_client_id_ = 1;
+        std::vector<ClientConnection*> waiting_clients_;   // Clients with a backlog, in round-robin order
+        std::vector<ClientConnection*> served_clients_;    // Submitted commands since the last FlushServedClients()
+        std::atomic<double> rate_limit_{ 0.0 };
+        std::atomic<double> rate_burst_{ 0.0 };
+        ClientStatsSlot client_stats_[MAX_CLIENTS];
+        mutable std::mutex stats_mutex_;
+
+        SocketHandle operator_listener_ = INVALID_SOCKET_HANDLE;
+        int operator_port_ = 0;
+
+        SocketHandle metrics_listener_ = INVALID_SOCKET_HANDLE;
+        int metrics_port_ = 0;
+        MetricsWriter metrics_;                        // Reused for every scrape
+        std::function<void(MetricsWriter&)> append_metrics_;
+
+        std::atomic<int> clients_connected_{ 0 };
+        std::atomic<uint64_t> connections_accepted_{ 0 };
+        std::atomic<uint64_t> connections_rejected_{ 0 };
+        std::atomic<uint64_t> commands_throttled_{ 0 };
+        std::atomic<uint64_t> commands_rate_limited_{ 0 };
+        mutable std::mutex address_mutex_;
+        std::string last_address_ = "None";           // Most recently connected client
+    };
+
+}
@@ -0,0 +1,92 @@
+#include "technique_catalog.hpp"
+
+namespace streamerbot {
+
+    void TechniqueCatalog::Rebuild(EffectRuntime& runtime) {
+        Clear();
+
+        runtime.EnumerateTechniques([this](TechniqueHandle technique, std::string_view name) {
+            Entry entry;
+            entry.handle = technique;
+            entry.name.assign(name.data(), name.size());
+            entry.name_lower = entry.name;
+            std::transform(entry.name_lower.begin(), entry.name_lower.end(), entry.name_lower.begin(), FoldAscii);
+            entries_.push_back(std::move(entry));
+            });
+
+        // Index only once entries_ has stopped growing, since the keys view its strings
+        exact_index_.reserve(entries_.size());
+        lower_index_.reserve(entries_.size());
+        for (uint32_t i = (uint32_t)entries_.size(); i-- > 0;) {
+            Entry& entry = entries_[i];
+            auto exact = exact_index_.emplace(entry.name, i);
+            if (!exact.second) {
+                entry.next_same_name = exact.first->second;
+                exact.first->second = i;
+            }
+            auto lower = lower_index_.emplace(entry.name_lower, i);
+            if (!lower.second) {
+                entry.next_same_lower = lower.first->second;
+                lower.first->second = i;
+            }
+        }
+
+        // Posting lists come out sorted because entries are visited in index order
+        for (uint32_t i = 0; i < (uint32_t)entries_.size(); ++i) {
+            const std::string& name = entries_[i].name_lower;
+            for (size_t pos = 0; pos + 3 <= name.size(); ++pos) {
+                std::vector<uint32_t>& postings = trigram_index_[Trigram(name.data() + pos)];
+                if (postings.empty() || postings.back() != i) {
+                    postings.push_back(i);
+                }
+            }
+        }
+    }
+
+    const std::vector<uint32_t>& TechniqueCatalog::PartialMatches(std::string_view query_lower) {
+        auto cached = match_cache_index_.find(query_lower);
+        if (cached != match_cache_index_.end()) {
+            match_cache_.splice(match_cache_.begin(), match_cache_, cached->second);
+            return cached->second->indices;
+        }
+
+        if (match_cache_.size() >= MATCH_CACHE_CAPACITY) {
+            match_cache_index_.erase(match_cache_.back().query_lower);
+            match_cache_.pop_back();
+        }
+        match_cache_.emplace_front();
+        CachedMatches& result = match_cache_.front();
+        result.query_lower.assign(query_lower.data(), query_lower.size());
+        match_cache_index_.emplace(result.query_lower, match_cache_.begin());
+
+        auto contains = [&](uint32_t i) {
+            return std::string_view(entries_[i].name_lower).find(query_lower) != std::string_view::npos;
+        };
+
+        if (query_lower.size() < 3) {
+            // Too short for a trigram; these match most of the catalog anyway
+            for (uint32_t i = 0; i < (uint32_t)entries_.size(); ++i) {
+                if (contains(i)) result.indices.push_back(i);
+            }
+            return result.indices;
+        }
+
+        // Every match contains all of the query's trigrams, so verifying the rarest
+        // trigram's posting list is enough
+        const std::vector<uint32_t>* candidates = nullptr;
+        for (size_t pos = 0; pos + 3 <= query_lower.size(); ++pos) {
+            auto postings = trigram_index_.find(Trigram(query_lower.data() + pos));
+            if (postings == trigram_index_.end()) {
+                return result.indices;
+            }
+            if (!candidates || postings->second.size() < candidates->size()) {
+                candidates = &postings->second;
+            }
+        }
+        for (uint32_t i : *candidates) {
+            if (contains(i)) result.indices.push_back(i);
+        }
+        return result.indices;
+    }
+
+}
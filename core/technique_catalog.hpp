@@ -0,0 +1,104 @@
+#pragma once
+#include "command.hpp"
+#include "effect_runtime.hpp"
+#include "text.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace streamerbot {
+
+    constexpr size_t MATCH_CACHE_CAPACITY = 128;    // Partial-match results kept per catalog
+
+    // Technique handles and names, rebuilt whenever effects are (re)loaded so that commands
+    // never enumerate the runtime. Lookups probe a hash index on the exact name first, then
+    // one on the pre-folded lowercase name. Partial names are answered from a trigram index
+    // over the lowercase names, with recent results kept in an LRU cache. Render thread only.
+    class TechniqueCatalog {
+    public:
+        static constexpr uint32_t NONE = UINT32_MAX;
+
+        struct Entry {
+            TechniqueHandle handle = 0;
+            std::string name;
+            std::string name_lower;
+            uint32_t next_same_name = NONE;    // Techniques in other effect files can share a name
+            uint32_t next_same_lower = NONE;
+        };
+
+        void Rebuild(EffectRuntime& runtime);
+
+        void Clear() {
+            exact_index_.clear();
+            lower_index_.clear();
+            trigram_index_.clear();
+            match_cache_.clear();
+            match_cache_index_.clear();
+            entries_.clear();
+        }
+
+        size_t Size() const { return entries_.size(); }
+        const Entry& operator[](size_t index) const { return entries_[index]; }
+        uint32_t IndexOf(const Entry& entry) const { return (uint32_t)(&entry - entries_.data()); }
+
+        // Invokes on_match(const Entry&) for every technique matching the query: the exact
+        // name if it exists, otherwise a case-insensitive exact match, otherwise every
+        // technique whose name contains the query. Returns the number of matches.
+        template <typename OnMatch>
+        size_t ForEachMatch(std::string_view query, OnMatch&& on_match) {
+            size_t matches = 0;
+
+            auto exact = exact_index_.find(query);
+            if (exact != exact_index_.end()) {
+                for (uint32_t i = exact->second; i != NONE; i = entries_[i].next_same_name, ++matches) {
+                    on_match(entries_[i]);
+                }
+                return matches;
+            }
+
+            char folded[MAX_TARGET_LENGTH];
+            if (query.size() > sizeof(folded)) return 0;
+            std::transform(query.begin(), query.end(), folded, FoldAscii);
+            const std::string_view query_lower(folded, query.size());
+
+            auto lower = lower_index_.find(query_lower);
+            if (lower != lower_index_.end()) {
+                for (uint32_t i = lower->second; i != NONE; i = entries_[i].next_same_lower, ++matches) {
+                    on_match(entries_[i]);
+                }
+                return matches;
+            }
+
+            const std::vector<uint32_t>& partial = PartialMatches(query_lower);
+            for (uint32_t i : partial) {
+                on_match(entries_[i]);
+            }
+            return partial.size();
+        }
+
+    private:
+        struct CachedMatches {
+            std::string query_lower;
+            std::vector<uint32_t> indices;
+        };
+
+        static uint32_t Trigram(const char* p) {
+            return ((uint32_t)(uint8_t)p[0] << 16) | ((uint32_t)(uint8_t)p[1] << 8) | (uint8_t)p[2];
+        }
+
+        // Indices of every technique whose lowercase name contains query_lower
+        const std::vector<uint32_t>& PartialMatches(std::string_view query_lower);
+
+        std::vector<Entry> entries_;
+        std::unordered_map<std::string_view, uint32_t> exact_index_;   // Name -> first entry with that name
+        std::unordered_map<std::string_view, uint32_t> lower_index_;   // Lowercase name -> first entry
+        std::unordered_map<uint32_t, std::vector<uint32_t>> trigram_index_;  // Trigram -> sorted entry indices
+        std::list<CachedMatches> match_cache_;                          // Most recently used first
+        std::unordered_map<std::string_view, std::list<CachedMatches>::iterator> match_cache_index_;
+    };
+
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <string_view>
+
+namespace streamerbot {
+
+    constexpr char FoldAscii(char c) {
+        return (c >= 'A' && c <= 'Z') ? (char)(c + ('a' - 'A')) : c;
+    }
+
+    constexpr bool EqualsIgnoreCase(std::string_view a, std::string_view b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); ++i) {
+            if (FoldAscii(a[i]) != FoldAscii(b[i])) return false;
+        }
+        return true;
+    }
+
+    inline bool ContainsIgnoreCase(std::string_view haystack, std::string_view needle) {
+        for (size_t i = 0; i + needle.size() <= haystack.size(); ++i) {
+            if (EqualsIgnoreCase(haystack.substr(i, needle.size()), needle)) return true;
+        }
+        return false;
+    }
+
+    inline std::string_view Trim(std::string_view value) {
+        while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) value.remove_prefix(1);
+        while (!value.empty() && (value.back() == ' ' || value.back() == '\t' || value.back() == '\r')) value.remove_suffix(1);
+        return value;
+    }
+
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace streamerbot {
+
+    // Hierarchical timer wheel. Level 0 has one slot per tick; each higher level has one slot
+    // per full turn of the level below, and its timers cascade down one level at a time as
+    // their turn comes up. Scheduling is O(1), and advancing costs O(1) per elapsed tick plus
+    // the timers that fire, however many are pending. Single-threaded.
+    template <typename T>
+    class TimerWheel {
+    public:
+        static constexpr int SLOT_BITS = 6;
+        static constexpr size_t SLOTS = size_t(1) << SLOT_BITS;
+        static constexpr int LEVELS = 5;
+        static constexpr uint64_t MAX_TICKS = (uint64_t(1) << (SLOT_BITS * LEVELS)) - 1;    // Longer timers fire at this horizon
+
+        explicit TimerWheel(int64_t tick_ns) : tick_ns_(tick_ns) {}
+
+        // Fires payload on the first Advance() at or after deadline_ns. Deadlines are placed
+        // relative to the last Advance(), so advance the wheel to the current time first.
+        void Schedule(int64_t deadline_ns, const T& payload) {
+            uint64_t expiry = Tick(deadline_ns);
+            if (expiry <= current_tick_) expiry = current_tick_ + 1;
+            if (expiry - current_tick_ > MAX_TICKS) expiry = current_tick_ + MAX_TICKS;
+            Insert(Timer{ expiry, payload });
+            ++size_;
+        }
+
+        // Moves the wheel to now_ns, calling on_expire(const T&) for every timer that is due
+        template <typename OnExpire>
+        void Advance(int64_t now_ns, OnExpire&& on_expire) {
+            const uint64_t target = Tick(now_ns);
+            if (size_ == 0) {
+                // Nothing can fire; skip the idle ticks
+                if (target > current_tick_) current_tick_ = target;
+                return;
+            }
+
+            while (current_tick_ < target && size_ > 0) {
+                ++current_tick_;
+
+                // Refill the lower levels from the highest level whose turn starts now
+                for (int level = LEVELS - 1; level > 0; --level) {
+                    if ((current_tick_ & ((uint64_t(1) << (SLOT_BITS * level)) - 1)) == 0) {
+                        Cascade(level);
+                    }
+                }
+
+                std::vector<Timer>& slot = slots_[0][current_tick_ & (SLOTS - 1)];
+                if (slot.empty()) continue;
+                firing_.swap(slot);
+                size_ -= firing_.size();
+                for (const Timer& timer : firing_) {
+                    on_expire(timer.payload);
+                }
+                firing_.clear();
+            }
+            if (target > current_tick_) current_tick_ = target;
+        }
+
+        void Clear() {
+            for (auto& level : slots_) {
+                for (std::vector<Timer>& slot : level) {
+                    slot.clear();
+                }
+            }
+            size_ = 0;
+        }
+
+        size_t Size() const { return size_; }
+
+    private:
+        struct Timer {
+            uint64_t expiry;
+            T payload;
+        };
+
+        uint64_t Tick(int64_t time_ns) const { return time_ns <= 0 ? 0 : (uint64_t)(time_ns / tick_ns_); }
+
+        void Insert(Timer&& timer) {
+            const uint64_t delta = timer.expiry - current_tick_;
+            int level = 0;
+            while (level < LEVELS - 1 && delta >= (uint64_t(1) << (SLOT_BITS * (level + 1)))) {
+                ++level;
+            }
+            slots_[level][(timer.expiry >> (SLOT_BITS * level)) & (SLOTS - 1)].push_back(std::move(timer));
+        }
+
+        void Cascade(int level) {
+            std::vector<Timer>& slot = slots_[level][(current_tick_ >> (SLOT_BITS * level)) & (SLOTS - 1)];
+            if (slot.empty()) return;
+            cascading_.swap(slot);
+            for (Timer& timer : cascading_) {
+                Insert(std::move(timer));
+            }
+            cascading_.clear();
+        }
+
+        const int64_t tick_ns_;
+        uint64_t current_tick_ = 0;
+        size_t size_ = 0;
+        std::vector<Timer> slots_[LEVELS][SLOTS];
+        std::vector<Timer> firing_;         // Swapped with the slot being fired, so slots keep their capacity
+        std::vector<Timer> cascading_;
+    };
+
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace streamerbot {
+
+    // Platform socket, file descriptor or loopback endpoint id
+    using SocketHandle = uintptr_t;
+    constexpr SocketHandle INVALID_SOCKET_HANDLE = ~(SocketHandle)0;
+
+    enum class IoStatus {
+        Ok,
+        WouldBlock,
+        Closed,      // Peer closed the connection
+        Error,
+    };
+
+    struct IoResult {
+        IoStatus status = IoStatus::Ok;
+        size_t bytes = 0;
+        int error = 0;              // Platform error code when status is Error
+    };
+
+    // Readiness event reported by a poller backend
+    struct PollEvent {
+        SocketHandle socket = INVALID_SOCKET_HANDLE;
+        bool readable = false;
+        bool writable = false;
+        bool error = false;
+    };
+
+    // Readiness notification backend used by the server loop. One poller multiplexes the
+    // listening socket and every client socket on the server thread.
+    class Poller {
+    public:
+        virtual ~Poller() = default;
+        virtual bool Add(SocketHandle socket) = 0;
+        virtual bool SetWriteInterest(SocketHandle socket, bool enabled) = 0;
+        virtual void Remove(SocketHandle socket) = 0;
+        // Blocks until at least one socket is ready, Wake() is called or the timeout expires.
+        // Returns the number of events written, 0 on timeout or wakeup and -1 on failure.
+        virtual int Wait(PollEvent* events, int max_events, int timeout_ms) = 0;
+        // Interrupts a Wait() in progress, or makes the next one return at once if none is.
+        // Safe to call from any thread.
+        virtual void Wake() = 0;
+    };
+
+    // Socket layer used by the server. Every socket it hands out is non-blocking.
+    class Transport {
+    public:
+        virtual ~Transport() = default;
+
+        virtual bool Startup(std::string& error) = 0;
+        virtual void Cleanup() = 0;
+
+        // Opens a listening socket on every interface, or on 127.0.0.1 only if loopback_only
+        // is set. Returns INVALID_SOCKET_HANDLE and describes the failure in error if that is
+        // not possible.
+        virtual SocketHandle Listen(int port, bool loopback_only, std::string& error) = 0;
+        // Accepts one pending connection and reports the peer address
+        virtual IoResult Accept(SocketHandle listener, SocketHandle& client, std::string& address) = 0;
+        virtual IoResult Recv(SocketHandle socket, char* buffer, size_t size) = 0;
+        virtual IoResult Send(SocketHandle socket, const char* data, size_t size) = 0;
+        virtual void Close(SocketHandle socket) = 0;
+        // Last platform error, for failures that do not return an IoResult
+        virtual int LastError() const = 0;
+
+        virtual std::unique_ptr<Poller> CreatePoller() = 0;
+    };
+
+    // Winsock on Windows, BSD sockets everywhere else
+    std::unique_ptr<Transport> CreatePlatformTransport();
+
+}
@@ -0,0 +1,148 @@
+#include "tween_engine.hpp"
+#include "uniform_catalog.hpp"
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define STREAMERBOT_TWEEN_SSE2 1
+#endif
+
+namespace streamerbot {
+
+    namespace {
+        struct EasingCurve {
+            float a, b, c;
+        };
+
+        // Indexed by TweenEasing
+        constexpr EasingCurve EASING_CURVES[] = {
+            { 1.0f, 0.0f, 0.0f },       // Linear: t
+            { 0.0f, 1.0f, 0.0f },       // EaseIn: t^2
+            { 2.0f, -1.0f, 0.0f },      // EaseOut: 1 - (1 - t)^2
+            { 0.0f, 3.0f, -2.0f },      // EaseInOut: smoothstep
+            { 0.0f, 0.0f, 1.0f },       // EaseInCubic: t^3
+            { 3.0f, -3.0f, 1.0f },      // EaseOutCubic: 1 - (1 - t)^3
+        };
+    }
+
+    void TweenEngine::Start(UniformHandle variable, UniformBaseType base, const float* from, const float* to, size_t count,
+        int64_t duration_ns, TweenEasing easing, int64_t now_ns) {
+        Cancel(variable);
+        if (tweens_.empty()) {
+            epoch_ns_ = now_ns;
+        }
+
+        const float start = Seconds(now_ns);
+        const float duration = (float)((double)duration_ns * 1e-9);
+        const EasingCurve& curve = EASING_CURVES[(size_t)easing];
+
+        Tween tween;
+        tween.variable = variable;
+        tween.base = base;
+        tween.first_lane = (uint32_t)value_.size();
+        tween.lanes = (uint32_t)count;
+        tween.end = start + duration;
+        tweens_.push_back(tween);
+
+        for (size_t i = 0; i < count; ++i) {
+            start_.push_back(start);
+            inv_duration_.push_back(1.0f / duration);
+            from_.push_back(from[i]);
+            to_.push_back(to[i]);
+            curve_a_.push_back(curve.a);
+            curve_b_.push_back(curve.b);
+            curve_c_.push_back(curve.c);
+            value_.push_back(from[i]);
+        }
+    }
+
+    void TweenEngine::Cancel(UniformHandle variable) {
+        auto it = std::find_if(tweens_.begin(), tweens_.end(), [variable](const Tween& tween) { return tween.variable == variable; });
+        if (it == tweens_.end()) return;
+
+        RemoveLanes(it->first_lane, it->lanes);
+        tweens_.erase(it);
+    }
+
+    void TweenEngine::Clear() {
+        tweens_.clear();
+        for (std::vector<float>* lanes : LaneArrays()) {
+            lanes->clear();
+        }
+    }
+
+    void TweenEngine::Evaluate(EffectRuntime& runtime, int64_t now_ns) {
+        if (tweens_.empty()) return;
+
+        const float now = Seconds(now_ns);
+        EvaluateLanes(now);
+
+        for (const Tween& tween : tweens_) {
+            WriteUniformValues(runtime, tween.variable, tween.base, &value_[tween.first_lane], std::min<size_t>(tween.lanes, MAX_UNIFORM_VALUES));
+        }
+
+        // Finished tweens were written at their end value above. Compact the survivors in
+        // one pass so that many tweens ending together stay linear.
+        size_t kept = 0;
+        uint32_t next_lane = 0;
+        for (const Tween& tween : tweens_) {
+            if (now >= tween.end) continue;
+
+            if (tween.first_lane != next_lane) {
+                for (std::vector<float>* lanes : LaneArrays()) {
+                    std::copy(lanes->begin() + tween.first_lane, lanes->begin() + tween.first_lane + tween.lanes, lanes->begin() + next_lane);
+                }
+            }
+            tweens_[kept] = tween;
+            tweens_[kept].first_lane = next_lane;
+            next_lane += tween.lanes;
+            ++kept;
+        }
+        tweens_.resize(kept);
+        for (std::vector<float>* lanes : LaneArrays()) {
+            lanes->resize(next_lane);
+        }
+    }
+
+    // value = from + (to - from) * e(t), t = clamp((now - start) / duration, 0, 1), with e(t)
+    // evaluated as t * (a + t * (b + t * c))
+    void TweenEngine::EvaluateLanes(float now) {
+        const size_t lanes = value_.size();
+        size_t i = 0;
+
+#ifdef STREAMERBOT_TWEEN_SSE2
+        const __m128 now4 = _mm_set1_ps(now);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        for (; i + 4 <= lanes; i += 4) {
+            __m128 t = _mm_mul_ps(_mm_sub_ps(now4, _mm_loadu_ps(&start_[i])), _mm_loadu_ps(&inv_duration_[i]));
+            t = _mm_min_ps(_mm_max_ps(t, zero), one);
+            __m128 eased = _mm_add_ps(_mm_loadu_ps(&curve_b_[i]), _mm_mul_ps(t, _mm_loadu_ps(&curve_c_[i])));
+            eased = _mm_add_ps(_mm_loadu_ps(&curve_a_[i]), _mm_mul_ps(t, eased));
+            eased = _mm_mul_ps(t, eased);
+            const __m128 from = _mm_loadu_ps(&from_[i]);
+            const __m128 to = _mm_loadu_ps(&to_[i]);
+            _mm_storeu_ps(&value_[i], _mm_add_ps(from, _mm_mul_ps(_mm_sub_ps(to, from), eased)));
+        }
+#endif
+
+        for (; i < lanes; ++i) {
+            const float t = std::min(std::max((now - start_[i]) * inv_duration_[i], 0.0f), 1.0f);
+            const float eased = t * (curve_a_[i] + t * (curve_b_[i] + t * curve_c_[i]));
+            value_[i] = from_[i] + (to_[i] - from_[i]) * eased;
+        }
+    }
+
+    void TweenEngine::RemoveLanes(uint32_t first, uint32_t count) {
+        for (std::vector<float>* lanes : LaneArrays()) {
+            lanes->erase(lanes->begin() + first, lanes->begin() + first + count);
+        }
+
+        for (Tween& tween : tweens_) {
+            if (tween.first_lane > first) {
+                tween.first_lane -= count;
+            }
+        }
+    }
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "effect_runtime.hpp"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace streamerbot {
+
+    // Easing curves. Each is a cubic e(t) = a*t + b*t^2 + c*t^3 with e(0) = 0 and e(1) = 1, so
+    // every lane runs the same arithmetic whatever its curve.
+    enum class TweenEasing : uint8_t {
+        Linear,
+        EaseIn,
+        EaseOut,
+        EaseInOut,
+        EaseInCubic,
+        EaseOutCubic,
+    };
+
+    // Animates uniform variables from one value to another over a duration. Every animated
+    // component is a lane in a structure of arrays; Evaluate() interpolates four lanes per
+    // SIMD instruction where SSE2 is available, then writes each tween's uniform once.
+    // Render thread only.
+    class TweenEngine {
+    public:
+        // Starts a tween over the first count components, replacing any tween on the same
+        // variable. duration_ns must be positive.
+        void Start(UniformHandle variable, UniformBaseType base, const float* from, const float* to, size_t count,
+            int64_t duration_ns, TweenEasing easing, int64_t now_ns);
+        // Stops animating a variable, leaving it at its current value
+        void Cancel(UniformHandle variable);
+        void Clear();
+
+        // Advances every tween to now_ns and writes the results. Finished tweens are written
+        // one last time at their end value and removed.
+        void Evaluate(EffectRuntime& runtime, int64_t now_ns);
+
+        size_t Active() const { return tweens_.size(); }
+
+    private:
+        struct Tween {
+            UniformHandle variable;
+            UniformBaseType base;
+            uint32_t first_lane;
+            uint32_t lanes;
+            float end;                  // Seconds since epoch_ns_
+        };
+
+        float Seconds(int64_t now_ns) const { return (float)((double)(now_ns - epoch_ns_) * 1e-9); }
+        void EvaluateLanes(float now);
+        void RemoveLanes(uint32_t first, uint32_t count);
+        std::array<std::vector<float>*, 8> LaneArrays() {
+            return { &start_, &inv_duration_, &from_, &to_, &curve_a_, &curve_b_, &curve_c_, &value_ };
+        }
+
+        std::vector<Tween> tweens_;
+        int64_t epoch_ns_ = 0;          // Rebased whenever no tween is active, to keep lane times small
+
+        // Lanes, one per animated component
+        std::vector<float> start_;
+        std::vector<float> inv_duration_;
+        std::vector<float> from_;
+        std::vector<float> to_;
+        std::vector<float> curve_a_;
+        std::vector<float> curve_b_;
+        std::vector<float> curve_c_;
+        std::vector<float> value_;
+    };
+
+}
@@ -0,0 +1,48 @@
+#include "uniform_catalog.hpp"
+#include "command.hpp"
+#include "text.hpp"
+#include <algorithm>
+
+namespace streamerbot {
+
+    void UniformCatalog::Rebuild(EffectRuntime& runtime) {
+        Clear();
+
+        runtime.EnumerateUniforms([this](UniformHandle variable, std::string_view effect_name,
+            std::string_view variable_name, const UniformType& type) {
+            Entry entry;
+            entry.handle = variable;
+            entry.type = type;
+            entry.name.reserve(effect_name.size() + 1 + variable_name.size());
+            entry.name.append(effect_name.data(), effect_name.size());
+            entry.name += '/';
+            entry.name.append(variable_name.data(), variable_name.size());
+            entry.name_lower = entry.name;
+            std::transform(entry.name_lower.begin(), entry.name_lower.end(), entry.name_lower.begin(), FoldAscii);
+            entries_.push_back(std::move(entry));
+            });
+
+        // Index only once entries_ has stopped growing, since the keys view its strings
+        exact_index_.reserve(entries_.size());
+        lower_index_.reserve(entries_.size());
+        for (uint32_t i = 0; i < (uint32_t)entries_.size(); ++i) {
+            exact_index_.emplace(entries_[i].name, i);
+            lower_index_.emplace(entries_[i].name_lower, i);
+        }
+    }
+
+    const UniformCatalog::Entry* UniformCatalog::Find(std::string_view name) const {
+        auto exact = exact_index_.find(name);
+        if (exact != exact_index_.end()) {
+            return &entries_[exact->second];
+        }
+
+        char folded[MAX_TARGET_LENGTH];
+        if (name.size() > sizeof(folded)) return nullptr;
+        std::transform(name.begin(), name.end(), folded, FoldAscii);
+
+        auto lower = lower_index_.find(std::string_view(folded, name.size()));
+        return lower != lower_index_.end() ? &entries_[lower->second] : nullptr;
+    }
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include "effect_runtime.hpp"
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace streamerbot {
+
+    constexpr size_t MAX_UNIFORM_VALUES = 16;       // Enough for a float4x4
+
+    // Converts a value to a uniform base type: rounded and clamped for integers, nonzero for bool
+    template <typename T, typename V>
+    T ConvertUniformValue(V value) {
+        if constexpr (std::is_same_v<T, bool>) {
+            return value != 0;
+        }
+        else if constexpr (std::is_floating_point_v<T>) {
+            return (T)value;
+        }
+        else {
+            const double rounded = std::round((double)value);
+            if (!(rounded > (double)std::numeric_limits<T>::lowest())) return std::numeric_limits<T>::lowest();
+            // (max)() stays a function call even where windows.h defines a max macro
+            if (!(rounded < (double)(std::numeric_limits<T>::max)())) return (std::numeric_limits<T>::max)();
+            return (T)rounded;
+        }
+    }
+
+    // Converts values to the uniform's base type and writes its first count components
+    template <typename V>
+    void WriteUniformValues(EffectRuntime& runtime, UniformHandle variable, UniformBaseType base, const V* values, size_t count) {
+        auto write = [&](auto* converted) {
+            using T = std::remove_pointer_t<decltype(converted)>;
+            for (size_t i = 0; i < count; ++i) {
+                converted[i] = ConvertUniformValue<T>(values[i]);
+            }
+            runtime.SetUniformValues(variable, (const T*)converted, count);
+        };
+
+        switch (base) {
+        case UniformBaseType::Bool: { bool converted[MAX_UNIFORM_VALUES]; write(converted); break; }
+        case UniformBaseType::Int: { int32_t converted[MAX_UNIFORM_VALUES]; write(converted); break; }
+        case UniformBaseType::Uint: { uint32_t converted[MAX_UNIFORM_VALUES]; write(converted); break; }
+        case UniformBaseType::Float: { float converted[MAX_UNIFORM_VALUES]; write(converted); break; }
+        }
+    }
+
+    // Uniform variable handles and types keyed by "Effect.fx/Variable", rebuilt whenever
+    // effects are (re)loaded so that commands never search the runtime by name. Render
+    // thread only.
+    class UniformCatalog {
+    public:
+        struct Entry {
+            UniformHandle handle = 0;
+            UniformType type;
+            std::string name;           // "Effect.fx/Variable"
+            std::string name_lower;
+        };
+
+        void Rebuild(EffectRuntime& runtime);
+
+        void Clear() {
+            exact_index_.clear();
+            lower_index_.clear();
+            entries_.clear();
+        }
+
+        size_t Size() const { return entries_.size(); }
+        const Entry& operator[](size_t index) const { return entries_[index]; }
+
+        // The uniform with exactly this name, otherwise the first one whose name matches
+        // case-insensitively, otherwise nullptr
+        const Entry* Find(std::string_view name) const;
+
+    private:
+        std::vector<Entry> entries_;
+        std::unordered_map<std::string_view, uint32_t> exact_index_;   // Name -> entry
+        std::unordered_map<std::string_view, uint32_t> lower_index_;   // Lowercase name -> first entry
+    };
+
+}
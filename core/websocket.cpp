@@ -0,0 +1,232 @@
+#include "websocket.hpp"
+#include "text.hpp"
+#include <cstring>
+#include <vector>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace streamerbot {
+    namespace websocket {
+        namespace {
+            // SHA-1 digest, only used for the Sec-WebSocket-Accept handshake value
+            void Sha1(const uint8_t* data, size_t size, uint8_t digest[20]) {
+                uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+                auto rol = [](uint32_t v, int bits) { return (v << bits) | (v >> (32 - bits)); };
+
+                uint64_t bit_length = (uint64_t)size * 8;
+                size_t padded_size = ((size + 8) / 64 + 1) * 64;
+                std::vector<uint8_t> message(padded_size, 0);
+                memcpy(message.data(), data, size);
+                message[size] = 0x80;
+                for (int i = 0; i < 8; ++i) {
+                    message[padded_size - 1 - i] = (uint8_t)(bit_length >> (i * 8));
+                }
+
+                for (size_t block = 0; block < padded_size; block += 64) {
+                    uint32_t w[80];
+                    for (int i = 0; i < 16; ++i) {
+                        const uint8_t* p = &message[block + i * 4];
+                        w[i] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+                    }
+                    for (int i = 16; i < 80; ++i) {
+                        w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+                    }
+
+                    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+                    for (int i = 0; i < 80; ++i) {
+                        uint32_t f, k;
+                        if (i < 20) { f = (b & c) | (~b & d); k = 0x5A827999; }
+                        else if (i < 40) { f = b ^ c ^ d; k = 0x6ED9EBA1; }
+                        else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+                        else { f = b ^ c ^ d; k = 0xCA62C1D6; }
+                        uint32_t temp = rol(a, 5) + f + e + k + w[i];
+                        e = d; d = c; c = rol(b, 30); b = a; a = temp;
+                    }
+                    h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+                }
+
+                for (int i = 0; i < 5; ++i) {
+                    digest[i * 4 + 0] = (uint8_t)(h[i] >> 24);
+                    digest[i * 4 + 1] = (uint8_t)(h[i] >> 16);
+                    digest[i * 4 + 2] = (uint8_t)(h[i] >> 8);
+                    digest[i * 4 + 3] = (uint8_t)h[i];
+                }
+            }
+
+            std::string Base64(const uint8_t* data, size_t size) {
+                const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+                std::string out;
+                out.reserve((size + 2) / 3 * 4);
+                for (size_t i = 0; i < size; i += 3) {
+                    uint32_t v = (uint32_t)data[i] << 16;
+                    if (i + 1 < size) v |= (uint32_t)data[i + 1] << 8;
+                    if (i + 2 < size) v |= data[i + 2];
+                    out.push_back(table[(v >> 18) & 0x3F]);
+                    out.push_back(table[(v >> 12) & 0x3F]);
+                    out.push_back(i + 1 < size ? table[(v >> 6) & 0x3F] : '=');
+                    out.push_back(i + 2 < size ? table[v & 0x3F] : '=');
+                }
+                return out;
+            }
+
+            std::string AcceptKey(std::string_view client_key) {
+                std::string input(client_key);
+                input += "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+                uint8_t digest[20];
+                Sha1((const uint8_t*)input.data(), input.size(), digest);
+                return Base64(digest, sizeof(digest));
+            }
+        }
+
+        bool ParseFrameHeader(const uint8_t* data, size_t size, FrameHeader& frame) {
+            if (size < 2) return false;
+
+            frame.fin = (data[0] & 0x80) != 0;
+            frame.opcode = data[0] & 0x0F;
+            frame.masked = (data[1] & 0x80) != 0;
+            frame.payload_size = data[1] & 0x7F;
+            size_t offset = 2;
+
+            if (frame.payload_size == 126) {
+                if (size < offset + 2) return false;
+                frame.payload_size = ((uint64_t)data[2] << 8) | data[3];
+                offset += 2;
+            }
+            else if (frame.payload_size == 127) {
+                if (size < offset + 8) return false;
+                frame.payload_size = 0;
+                for (int i = 0; i < 8; ++i) {
+                    frame.payload_size = (frame.payload_size << 8) | data[offset + i];
+                }
+                offset += 8;
+            }
+
+            if (frame.masked) {
+                if (size < offset + 4) return false;
+                memcpy(frame.mask, data + offset, 4);
+                offset += 4;
+            }
+
+            frame.header_size = offset;
+            return true;
+        }
+
+        void Unmask(uint8_t* payload, size_t size, const uint8_t mask[4]) {
+            size_t i = 0;
+    #if defined(_M_X64) || defined(__SSE2__)
+            uint32_t mask32;
+            memcpy(&mask32, mask, 4);
+            const __m128i key = _mm_set1_epi32((int)mask32);
+            for (; i + 16 <= size; i += 16) {
+                __m128i chunk = _mm_loadu_si128((const __m128i*)(payload + i));
+                _mm_storeu_si128((__m128i*)(payload + i), _mm_xor_si128(chunk, key));
+            }
+    #endif
+            for (; i < size; ++i) {
+                payload[i] ^= mask[i & 3];
+            }
+        }
+
+        bool IsValidUtf8(std::string_view text) {
+            const uint8_t* p = (const uint8_t*)text.data();
+            const uint8_t* const end = p + text.size();
+            while (p < end) {
+                if (end - p >= 8) {
+                    uint64_t chunk;
+                    memcpy(&chunk, p, 8);
+                    if ((chunk & 0x8080808080808080ull) == 0) {
+                        p += 8;
+                        continue;
+                    }
+                }
+                const uint8_t lead = *p;
+                if (lead < 0x80) {
+                    ++p;
+                    continue;
+                }
+
+                // Length of the sequence and the range its second byte must fall in, which
+                // rules out overlong forms, surrogates and code points past U+10FFFF
+                size_t length;
+                uint8_t low = 0x80, high = 0xBF;
+                if (lead >= 0xC2 && lead <= 0xDF) length = 2;
+                else if (lead >= 0xE0 && lead <= 0xEF) {
+                    length = 3;
+                    if (lead == 0xE0) low = 0xA0;
+                    else if (lead == 0xED) high = 0x9F;
+                }
+                else if (lead >= 0xF0 && lead <= 0xF4) {
+                    length = 4;
+                    if (lead == 0xF0) low = 0x90;
+                    else if (lead == 0xF4) high = 0x8F;
+                }
+                else return false;
+
+                if ((size_t)(end - p) < length || p[1] < low || p[1] > high) return false;
+                for (size_t i = 2; i < length; ++i) {
+                    if ((p[i] & 0xC0) != 0x80) return false;
+                }
+                p += length;
+            }
+            return true;
+        }
+
+        void AppendFrame(std::string& out, uint8_t opcode, std::string_view payload) {
+            out.push_back((char)(0x80 | opcode));
+            if (payload.size() < 126) {
+                out.push_back((char)payload.size());
+            }
+            else if (payload.size() <= 0xFFFF) {
+                out.push_back((char)126);
+                out.push_back((char)(payload.size() >> 8));
+                out.push_back((char)(payload.size() & 0xFF));
+            }
+            else {
+                out.push_back((char)127);
+                for (int shift = 56; shift >= 0; shift -= 8) {
+                    out.push_back((char)(((uint64_t)payload.size() >> shift) & 0xFF));
+                }
+            }
+            out.append(payload.data(), payload.size());
+        }
+
+        void AppendClose(std::string& out, uint16_t code) {
+            const char payload[2] = { (char)(code >> 8), (char)(code & 0xFF) };
+            AppendFrame(out, OP_CLOSE, std::string_view(payload, 2));
+        }
+
+        bool Handshake(std::string_view request, std::string& out) {
+            bool upgrade = false, connection_upgrade = false, version_ok = false;
+            std::string_view key;
+
+            size_t pos = request.find('\n');
+            while (pos != std::string_view::npos && pos + 1 < request.size()) {
+                size_t end = request.find('\n', pos + 1);
+                std::string_view line = request.substr(pos + 1, end == std::string_view::npos ? std::string_view::npos : end - pos - 1);
+                pos = end;
+
+                size_t colon = line.find(':');
+                if (colon == std::string_view::npos) continue;
+                std::string_view name = Trim(line.substr(0, colon));
+                std::string_view value = Trim(line.substr(colon + 1));
+
+                if (EqualsIgnoreCase(name, "Upgrade")) upgrade = EqualsIgnoreCase(value, "websocket");
+                else if (EqualsIgnoreCase(name, "Connection")) connection_upgrade = ContainsIgnoreCase(value, "upgrade");
+                else if (EqualsIgnoreCase(name, "Sec-WebSocket-Version")) version_ok = (value == "13");
+                else if (EqualsIgnoreCase(name, "Sec-WebSocket-Key")) key = value;
+            }
+
+            if (!upgrade || !connection_upgrade || !version_ok || key.empty()) {
+                out += "HTTP/1.1 400 Bad Request\r\nSec-WebSocket-Version: 13\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+                return false;
+            }
+
+            out += "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Accept: ";
+            out += AcceptKey(key);
+            out += "\r\n\r\n";
+            return true;
+        }
+    }
+}
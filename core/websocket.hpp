@@ -0,0 +1,56 @@
+#pragma once
+#include "line_framer.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// WebSocket (RFC 6455) support
+namespace streamerbot {
+    namespace websocket {
+        constexpr uint8_t OP_CONTINUATION = 0x0;
+        constexpr uint8_t OP_TEXT = 0x1;
+        constexpr uint8_t OP_BINARY = 0x2;
+        constexpr uint8_t OP_CLOSE = 0x8;
+        constexpr uint8_t OP_PING = 0x9;
+        constexpr uint8_t OP_PONG = 0xA;
+
+        constexpr uint16_t CLOSE_PROTOCOL_ERROR = 1002;
+        constexpr uint16_t CLOSE_UNSUPPORTED_DATA = 1003;
+        constexpr uint16_t CLOSE_INVALID_PAYLOAD = 1007;
+        constexpr uint16_t CLOSE_TOO_BIG = 1009;
+
+        constexpr size_t MAX_FRAME_HEADER_SIZE = 14;   // 2 bytes, 8-byte length, 4-byte mask
+        constexpr size_t MAX_CONTROL_PAYLOAD = 125;    // Close, ping and pong frames
+        // A frame is decoded in place from the connection's receive buffer, so header and
+        // payload must fit in it together. Reassembled messages share the same limit.
+        constexpr size_t MAX_MESSAGE_SIZE = RECV_BUFFER_SIZE - MAX_FRAME_HEADER_SIZE;
+
+        struct FrameHeader {
+            bool fin = false;
+            uint8_t opcode = 0;
+            bool masked = false;
+            uint8_t mask[4] = {};
+            size_t header_size = 0;
+            uint64_t payload_size = 0;
+        };
+
+        // Parses the frame header at data. Returns false if more bytes are needed.
+        bool ParseFrameHeader(const uint8_t* data, size_t size, FrameHeader& frame);
+
+        // Unmasks a client payload in place, 16 bytes per step where SSE2 is available
+        void Unmask(uint8_t* payload, size_t size, const uint8_t mask[4]);
+
+        // Whether text is well-formed UTF-8: no overlong forms, surrogates or code points past
+        // U+10FFFF. Runs of ASCII are checked 8 bytes per step.
+        bool IsValidUtf8(std::string_view text);
+
+        // Appends an unmasked server frame to out
+        void AppendFrame(std::string& out, uint8_t opcode, std::string_view payload);
+        void AppendClose(std::string& out, uint16_t code);
+
+        // Builds the reply to an HTTP upgrade request. Returns false if the request is not a
+        // valid WebSocket handshake; out then holds an HTTP error response.
+        bool Handshake(std::string_view request, std::string& out);
+    }
+}
@@ -0,0 +1,216 @@
+#include "transport.hpp"
+#define WIN32_LEAN_AND_MEAN  // Prevent windows.h from including winsock.h
+#ifndef NOMINMAX
+#define NOMINMAX             // Keep windows.h from defining min/max macros over std::min/std::max
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <vector>
+
+#pragma comment(lib, "ws2_32.lib")
+
+namespace streamerbot {
+
+    namespace {
+        // WSAPoll backend. WSAPoll can only wait on sockets, so Wake() sends a datagram to a
+        // UDP socket connected to itself.
+        class WSAPollPoller final : public Poller {
+        public:
+            WSAPollPoller() {
+                wake_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+                if (wake_ == INVALID_SOCKET) return;
+
+                sockaddr_in addr = {};
+                addr.sin_family = AF_INET;
+                addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                int addr_len = sizeof(addr);
+                if (bind(wake_, (sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR ||
+                    getsockname(wake_, (sockaddr*)&addr, &addr_len) == SOCKET_ERROR ||
+                    connect(wake_, (sockaddr*)&addr, addr_len) == SOCKET_ERROR) {
+                    closesocket(wake_);
+                    wake_ = INVALID_SOCKET;
+                    return;
+                }
+                u_long mode = 1;
+                ioctlsocket(wake_, FIONBIO, &mode);
+
+                WSAPOLLFD fd = {};
+                fd.fd = wake_;
+                fd.events = POLLRDNORM;
+                fds_.push_back(fd);
+            }
+            ~WSAPollPoller() override {
+                if (wake_ != INVALID_SOCKET) closesocket(wake_);
+            }
+
+            bool Add(SocketHandle socket) override {
+                WSAPOLLFD fd = {};
+                fd.fd = (SOCKET)socket;
+                fd.events = POLLRDNORM;
+                fds_.push_back(fd);
+                return true;
+            }
+
+            bool SetWriteInterest(SocketHandle socket, bool enabled) override {
+                for (auto& fd : fds_) {
+                    if (fd.fd == (SOCKET)socket) {
+                        fd.events = enabled ? (POLLRDNORM | POLLWRNORM) : POLLRDNORM;
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            void Remove(SocketHandle socket) override {
+                for (size_t i = 0; i < fds_.size(); ++i) {
+                    if (fds_[i].fd == (SOCKET)socket) {
+                        fds_[i] = fds_.back();
+                        fds_.pop_back();
+                        return;
+                    }
+                }
+            }
+
+            int Wait(PollEvent* events, int max_events, int timeout_ms) override {
+                int ready = WSAPoll(fds_.data(), (ULONG)fds_.size(), timeout_ms);
+                if (ready <= 0) {
+                    return ready == 0 ? 0 : -1;
+                }
+
+                int count = 0;
+                for (const auto& fd : fds_) {
+                    if (fd.revents == 0) continue;
+                    if (fd.fd == wake_) {
+                        char drain[64];
+                        while (recv(wake_, drain, sizeof(drain), 0) > 0) {}
+                        continue;
+                    }
+                    if (count == max_events) break;
+                    PollEvent& ev = events[count++];
+                    ev.socket = (SocketHandle)fd.fd;
+                    ev.readable = (fd.revents & (POLLRDNORM | POLLHUP)) != 0;
+                    ev.writable = (fd.revents & POLLWRNORM) != 0;
+                    ev.error = (fd.revents & (POLLERR | POLLNVAL)) != 0;
+                }
+                return count;
+            }
+
+            void Wake() override {
+                char one = 1;
+                send(wake_, &one, 1, 0);
+            }
+
+        private:
+            std::vector<WSAPOLLFD> fds_;
+            SOCKET wake_ = INVALID_SOCKET;
+        };
+
+        void SetNonBlocking(SOCKET socket) {
+            u_long mode = 1;
+            ioctlsocket(socket, FIONBIO, &mode);
+        }
+
+        IoResult SocketFailure() {
+            IoResult result;
+            result.error = WSAGetLastError();
+            result.status = (result.error == WSAEWOULDBLOCK) ? IoStatus::WouldBlock : IoStatus::Error;
+            return result;
+        }
+
+        class WinsockTransport final : public Transport {
+        public:
+            bool Startup(std::string& error) override {
+                WSADATA wsaData;
+                if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+                    error = "WSAStartup failed";
+                    return false;
+                }
+                return true;
+            }
+
+            void Cleanup() override {
+                WSACleanup();
+            }
+
+            SocketHandle Listen(int port, bool loopback_only, std::string& error) override {
+                SOCKET listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+                if (listener == INVALID_SOCKET) {
+                    error = "Socket creation failed";
+                    return INVALID_SOCKET_HANDLE;
+                }
+
+                int opt = 1;
+                setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (char*)&opt, sizeof(opt));
+                SetNonBlocking(listener);
+
+                sockaddr_in server_addr = {};
+                server_addr.sin_family = AF_INET;
+                server_addr.sin_addr.s_addr = htonl(loopback_only ? INADDR_LOOPBACK : INADDR_ANY);
+                server_addr.sin_port = htons((u_short)port);
+
+                if (bind(listener, (sockaddr*)&server_addr, sizeof(server_addr)) == SOCKET_ERROR) {
+                    error = "Bind failed on port " + std::to_string(port);
+                    closesocket(listener);
+                    return INVALID_SOCKET_HANDLE;
+                }
+                if (listen(listener, SOMAXCONN) == SOCKET_ERROR) {
+                    error = "Listen failed";
+                    closesocket(listener);
+                    return INVALID_SOCKET_HANDLE;
+                }
+                return (SocketHandle)listener;
+            }
+
+            IoResult Accept(SocketHandle listener, SocketHandle& client, std::string& address) override {
+                sockaddr_in client_addr = {};
+                int client_len = sizeof(client_addr);
+                SOCKET client_socket = accept((SOCKET)listener, (sockaddr*)&client_addr, &client_len);
+                if (client_socket == INVALID_SOCKET) {
+                    IoResult result = SocketFailure();
+                    if (result.error == WSAECONNABORTED) result.status = IoStatus::WouldBlock;
+                    return result;
+                }
+
+                SetNonBlocking(client_socket);
+                int nodelay = 1;
+                setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, (char*)&nodelay, sizeof(nodelay));
+
+                char addr_str[INET_ADDRSTRLEN];
+                inet_ntop(AF_INET, &client_addr.sin_addr, addr_str, INET_ADDRSTRLEN);
+                address = addr_str;
+                client = (SocketHandle)client_socket;
+                return IoResult();
+            }
+
+            IoResult Recv(SocketHandle socket, char* buffer, size_t size) override {
+                int received = recv((SOCKET)socket, buffer, (int)size, 0);
+                if (received == 0) return IoResult{ IoStatus::Closed, 0, 0 };
+                if (received < 0) return SocketFailure();
+                return IoResult{ IoStatus::Ok, (size_t)received, 0 };
+            }
+
+            IoResult Send(SocketHandle socket, const char* data, size_t size) override {
+                int sent = send((SOCKET)socket, data, (int)size, 0);
+                if (sent == SOCKET_ERROR) return SocketFailure();
+                return IoResult{ IoStatus::Ok, (size_t)sent, 0 };
+            }
+
+            void Close(SocketHandle socket) override {
+                closesocket((SOCKET)socket);
+            }
+
+            int LastError() const override {
+                return WSAGetLastError();
+            }
+
+            std::unique_ptr<Poller> CreatePoller() override {
+                return std::make_unique<WSAPollPoller>();
+            }
+        };
+    }
+
+    std::unique_ptr<Transport> CreatePlatformTransport() {
+        return std::make_unique<WinsockTransport>();
+    }
+
+}
@@ -0,0 +1,140 @@
+// Checks that the per-command paths do not touch the heap once warmed up. Every allocation in
+// the process goes through the counting operator new below, so this test has its own
+// executable.
+#include "check.hpp"
+#include "command.hpp"
+#include "command_engine.hpp"
+#include "loopback_transport.hpp"
+#include "mock_effect_runtime.hpp"
+#include "server.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+
+namespace {
+    std::atomic<uint64_t> g_allocations{ 0 };
+}
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+using namespace streamerbot;
+
+namespace {
+    constexpr int PORT = 7777;
+    constexpr int ROUNDS = 200;
+
+    LogRing g_log;
+
+    // Allocations made while running body
+    template <typename Body>
+    uint64_t CountAllocations(Body&& body) {
+        const uint64_t before = g_allocations.load();
+        body();
+        return g_allocations.load() - before;
+    }
+
+    void TestParse() {
+        const char* const lines[] = { "TOGGLE Bloom", "enable Motion Blur FOR 5s", "SET Vignette.fx/Radius 0.25",
+            "TWEEN Vignette.fx/Radius 1 OVER 500ms ease-in-out", "AT frame+2 DISABLE Bloom", "PRIORITY high TOGGLE Bloom" };
+        PendingCommand command;
+        CHECK(CountAllocations([&] {
+            for (int i = 0; i < ROUNDS; ++i) {
+                for (const char* line : lines) {
+                    command = PendingCommand();
+                    ParseCommand(line, command);
+                }
+            }
+        }) == 0);
+    }
+
+    void TestLogParts() {
+        const std::string command(MAX_LOG_MESSAGE, 'x');
+        CHECK(CountAllocations([&] {
+            g_log.Write({ "Received: ", "TOGGLE Bloom" }, LogColor());
+            g_log.Write({ "Received: ", command }, LogColor());
+        }) == 0);
+
+        LogEntry entry;
+        CHECK(g_log.Read(g_log.End() - 2, entry));
+        CHECK(entry.Message() == "Received: TOGGLE Bloom");
+        // Parts past the end of the slot are cut off
+        CHECK(g_log.Read(g_log.End() - 1, entry));
+        CHECK(entry.Message() == "Received: " + command.substr(0, MAX_LOG_MESSAGE - 10));
+    }
+
+    void TestEngineSubmit() {
+        MockEffectRuntime runtime;
+        CommandEngine commands{ g_log };
+        runtime.AddTechnique("Bloom");
+        runtime.AddUniform("Vignette.fx", "Radius", UniformType());
+        runtime.Reload(commands);
+
+        auto submit = [&] {
+            for (int i = 0; i < ROUNDS; ++i) {
+                commands.Submit("TOGGLE Bloom", MonotonicNs());
+                commands.Submit("SET Vignette.fx/Radius 0.5", MonotonicNs());
+            }
+        };
+        submit();
+        while (commands.Queued() > 0) runtime.Present(commands);
+        CHECK(CountAllocations(submit) == 0);
+    }
+
+    // A command from a loopback client through the server loop to the engine and its "OK"
+    void TestServerPath() {
+        LoopbackTransport transport;
+        MockEffectRuntime runtime;
+        CommandEngine commands{ g_log };
+        Server server{ transport, commands, g_log };
+        runtime.AddTechnique("Bloom");
+        runtime.Reload(commands);
+        server.Open(PORT);
+        std::atomic<bool> running{ true };
+        std::thread thread([&] { server.Run([&] { return running.load(); }); });
+
+        const SocketHandle client = transport.Connect(PORT);
+        bool answered = true;
+        auto round_trips = [&] {
+            for (int i = 0; i < ROUNDS && answered; ++i) {
+                transport.Send(client, "TOGGLE Bloom\n", 13);
+                char reply[16];
+                size_t received = 0;
+                const int64_t deadline = MonotonicNs() + 5000000000;
+                while (received < 3 && MonotonicNs() < deadline) {
+                    IoResult result = transport.Recv(client, reply + received, sizeof(reply) - received);
+                    if (result.status == IoStatus::Ok) received += result.bytes;
+                    else std::this_thread::yield();
+                }
+                answered = received == 3 && std::string_view(reply, 3) == "OK\n";
+            }
+        };
+        round_trips();
+        while (commands.Queued() > 0) runtime.Present(commands);
+        CHECK(CountAllocations(round_trips) == 0);
+        CHECK(answered);
+
+        running = false;
+        server.Wake();
+        thread.join();
+        transport.Close(client);
+    }
+}
+
+int main() {
+    TestParse();
+    TestLogParts();
+    TestEngineSubmit();
+    TestServerPath();
+    return test::Finish("allocation_test");
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdio>
+
+namespace streamerbot {
+    namespace test {
+
+        // Failed checks so far. Each test executable returns non-zero if any check failed.
+        inline int& Failures() {
+            static int failures = 0;
+            return failures;
+        }
+
+        inline void Fail(const char* file, int line, const char* expression) {
+            fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+            ++Failures();
+        }
+
+        // Reports the outcome of a test executable; return it from main()
+        inline int Finish(const char* name) {
+            if (Failures() == 0) {
+                printf("%s: all checks passed\n", name);
+                return 0;
+            }
+            printf("%s: %d check(s) failed\n", name, Failures());
+            return 1;
+        }
+
+    }
+}
+
+// Records a failure and carries on, so one run reports every broken check
+#define CHECK(expression) ((expression) ? (void)0 : ::streamerbot::test::Fail(__FILE__, __LINE__, #expression))
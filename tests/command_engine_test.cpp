@@ -0,0 +1,243 @@
+#include "check.hpp"
+#include "command_engine.hpp"
+#include "mock_effect_runtime.hpp"
+#include <chrono>
+#include <string>
+#include <thread>
+
+using namespace streamerbot;
+
+namespace {
+    LogRing g_log;
+
+    // An engine over a mock runtime with two techniques and two uniforms
+    struct Fixture {
+        MockEffectRuntime runtime;
+        CommandEngine commands{ g_log };
+        TechniqueHandle bloom = runtime.AddTechnique("Bloom");
+        TechniqueHandle blur = runtime.AddTechnique("MotionBlur", true);
+        UniformHandle radius = runtime.AddUniform("Vignette.fx", "Radius", UniformType());
+        UniformHandle steps = runtime.AddUniform("Blur.fx", "Steps", UniformType{ UniformBaseType::Int, 1, 1, 0 });
+
+        Fixture() { runtime.Reload(commands); }
+
+        CommandResult Submit(std::string_view line, CommandSource& source) { return commands.Submit(line, MonotonicNs(), source); }
+        CommandResult Submit(std::string_view line) { return commands.Submit(line, MonotonicNs()); }
+    };
+
+    void TestAppliedOnPresent() {
+        Fixture f;
+        CHECK(f.commands.Techniques().Size() == 2);
+        CHECK(f.Submit("TOGGLE Bloom") == CommandResult::Queued);
+        CHECK(!f.runtime.TechniqueState(f.bloom));
+        CHECK(f.commands.Queued() == 1);
+
+        // Nothing touches the runtime until the frame tick
+        f.runtime.Present(f.commands);
+        CHECK(f.runtime.TechniqueState(f.bloom));
+        CHECK(f.commands.CommandsApplied() == 1);
+        CHECK(f.commands.Queued() == 0);
+
+        CHECK(f.Submit("off motion") == CommandResult::Queued);
+        f.runtime.Present(f.commands);
+        CHECK(!f.runtime.TechniqueState(f.blur));
+    }
+
+    void TestCoalescing() {
+        Fixture f;
+        for (int i = 0; i < 5; ++i) {
+            CHECK(f.Submit("TOGGLE Bloom") == CommandResult::Queued);
+        }
+        CHECK(f.Submit("ENABLE MotionBlur") == CommandResult::Queued);
+        f.runtime.Present(f.commands);
+        // Five toggles fold into one call; enabling an enabled technique needs none
+        CHECK(f.runtime.TechniqueState(f.bloom));
+        CHECK(f.runtime.SetStateCalls() == 1);
+        CHECK(f.commands.CommandsCoalesced() == 4);
+    }
+
+    void TestBatches() {
+        Fixture f;
+        CommandSource source;
+        CHECK(f.Submit("BEGIN", source) == CommandResult::Staged);
+        CHECK(f.Submit("ENABLE Bloom", source) == CommandResult::Staged);
+        CHECK(f.Submit("SET Vignette.fx/Radius 0.25", source) == CommandResult::Staged);
+        CHECK(f.commands.Queued() == 0);
+        CHECK(f.Submit("COMMIT", source) == CommandResult::Queued);
+        CHECK(f.commands.Queued() == 2);
+
+        // The low lane budget cannot split a batch across frames
+        f.commands.SetLowPriorityBudget(1);
+        f.runtime.Present(f.commands);
+        CHECK(f.runtime.TechniqueState(f.bloom));
+        CHECK(f.runtime.UniformFloat(f.radius) == 0.25f);
+
+        CHECK(f.Submit("DISABLE Bloom; SET Blur.fx/Steps 7", source) == CommandResult::Queued);
+        f.runtime.Present(f.commands);
+        CHECK(!f.runtime.TechniqueState(f.bloom));
+        CHECK(f.runtime.UniformInt(f.steps) == 7);
+    }
+
+    void TestScheduledInBatch() {
+        Fixture f;
+        CommandSource source;
+        CHECK(f.Submit("BEGIN", source) == CommandResult::Staged);
+        CHECK(f.Submit("ENABLE Bloom", source) == CommandResult::Staged);
+        CHECK(f.Submit("AT frame+2 SET Vignette.fx/Radius 0.25", source) == CommandResult::Staged);
+        CHECK(f.Submit("COMMIT", source) == CommandResult::InvalidSchedule);
+        CHECK(f.Submit("ENABLE Bloom; AT t+1s DISABLE Bloom", source) == CommandResult::InvalidSchedule);
+        CHECK(f.commands.Queued() == 0);
+        f.runtime.Present(f.commands);
+        CHECK(!f.runtime.TechniqueState(f.bloom));
+        CHECK(f.commands.ScheduledCommands() == 0);
+    }
+
+    void TestDebouncedBatch() {
+        Fixture f;
+        CHECK(f.Submit("DEBOUNCE Bloom 10s") == CommandResult::Queued);
+        CHECK(f.Submit("ENABLE Bloom") == CommandResult::Queued);
+        f.runtime.Present(f.commands);
+        CHECK(f.runtime.TechniqueState(f.bloom));
+
+        // A lone command waits out the window
+        CHECK(f.Submit("DISABLE Bloom") == CommandResult::Queued);
+        f.runtime.Present(f.commands);
+        CHECK(f.runtime.TechniqueState(f.bloom));
+
+        // A batch still lands whole in one frame
+        CHECK(f.Submit("DISABLE Bloom; SET Blur.fx/Steps 3") == CommandResult::Queued);
+        f.runtime.Present(f.commands);
+        CHECK(!f.runtime.TechniqueState(f.bloom));
+        CHECK(f.runtime.UniformInt(f.steps) == 3);
+    }
+
+    void TestReplies() {
+        Fixture f;
+        CommandSource source;
+        source.client_id = 42;
+        CHECK(f.Submit("SET Vignette.fx/Radius 0.5", source) == CommandResult::Queued);
+        CHECK(f.Submit("GET Vignette.fx/Radius", source) == CommandResult::ReplyPending);
+        bool notified = false;
+        f.commands.SetReplyNotifier([&notified] { notified = true; });
+        f.runtime.Present(f.commands);
+
+        CommandReply reply;
+        CHECK(notified);
+        CHECK(f.commands.TryPopReply(reply));
+        CHECK(reply.client_id == 42);
+        CHECK(reply.Text() == "VALUE Vignette.fx/Radius 0.5");
+    }
+
+    void TestPriorityLanes() {
+        Fixture f;
+        f.commands.SetLowPriorityBudget(4);
+        CommandSource audience;
+        for (int i = 0; i < 10; ++i) {
+            CHECK(f.Submit("SET Blur.fx/Steps " + std::to_string(i), audience) == CommandResult::Queued);
+        }
+        CommandSource operator_source;
+        operator_source.priority = CommandPriority::High;
+        CHECK(f.Submit("ENABLE Bloom", operator_source) == CommandResult::Queued);
+        CHECK(f.commands.Queued(CommandPriority::High) == 1);
+
+        f.runtime.Present(f.commands);
+        CHECK(f.runtime.TechniqueState(f.bloom));
+        CHECK(f.runtime.UniformInt(f.steps) == 3);
+        f.runtime.Present(f.commands);
+        f.runtime.Present(f.commands);
+        CHECK(f.runtime.UniformInt(f.steps) == 9);
+    }
+
+    void TestScheduledCommands() {
+        Fixture f;
+        CHECK(f.Submit("AT frame+2 TOGGLE Bloom") == CommandResult::Queued);
+        f.runtime.Present(f.commands);
+        CHECK(!f.runtime.TechniqueState(f.bloom));
+        CHECK(f.commands.ScheduledCommands() == 1);
+        f.runtime.Present(f.commands);
+        CHECK(f.runtime.TechniqueState(f.bloom));
+        CHECK(f.commands.ScheduledCommands() == 0);
+    }
+
+    void TestLeases() {
+        Fixture f;
+        CHECK(f.Submit("ENABLE Bloom FOR 5ms") == CommandResult::Queued);
+        f.runtime.Present(f.commands);
+        CHECK(f.runtime.TechniqueState(f.bloom));
+        CHECK(f.commands.ActiveLeases() == 1);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        f.runtime.Present(f.commands);
+        CHECK(!f.runtime.TechniqueState(f.bloom));
+        CHECK(f.commands.ActiveLeases() == 0);
+    }
+
+    void TestInjectedLatency() {
+        Fixture f;
+        MockEffectRuntime::Latencies latencies;
+        latencies.set_state_ns = 2000000;
+        f.runtime.SetLatencies(latencies);
+        CHECK(f.Submit("TOGGLE Bloom") == CommandResult::Queued);
+
+        const int64_t start = MonotonicNs();
+        f.runtime.Present(f.commands);
+        CHECK(MonotonicNs() - start >= 2000000);
+        f.runtime.Present(f.commands);
+        // Total latency runs to the present after the one that applied the command
+        LatencySummary total = f.commands.Latency(LatencyStage::Total).Summarize();
+        CHECK(total.count == 1);
+        CHECK(total.p50_ns >= 2000000);
+    }
+
+    void TestTweenBroadcast() {
+        Fixture f;
+        UniformHandle color = f.runtime.AddUniform("Vignette.fx", "Color", UniformType{ UniformBaseType::Float, 1, 3, 0 });
+        f.runtime.Reload(f.commands);
+
+        // Single start and end values cover every component
+        CHECK(f.Submit("TWEEN Vignette.fx/Color 0 1 20ms") == CommandResult::Queued);
+        f.runtime.Present(f.commands);
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        f.runtime.Present(f.commands);
+        CHECK(f.runtime.UniformFloat(color, 0) == 1.0f);
+        CHECK(f.runtime.UniformFloat(color, 1) == 1.0f);
+        CHECK(f.runtime.UniformFloat(color, 2) == 1.0f);
+
+        // A single start value covers the components the end values name
+        CHECK(f.Submit("TWEEN Vignette.fx/Color 0 0.5,0.25 20ms") == CommandResult::Queued);
+        f.runtime.Present(f.commands);
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        f.runtime.Present(f.commands);
+        CHECK(f.runtime.UniformFloat(color, 0) == 0.5f);
+        CHECK(f.runtime.UniformFloat(color, 1) == 0.25f);
+        CHECK(f.runtime.UniformFloat(color, 2) == 1.0f);
+    }
+
+    void TestReloadAndClear() {
+        Fixture f;
+        f.runtime.AddTechnique("Sharpen");
+        CHECK(f.Submit("ENABLE Sharpen") == CommandResult::Queued);
+        f.runtime.Reload(f.commands);
+        f.runtime.Present(f.commands);
+        CHECK(f.runtime.TechniqueState(3));
+
+        f.commands.Clear();
+        CHECK(f.Submit("TOGGLE Bloom") == CommandResult::NoRuntime);
+    }
+}
+
+int main() {
+    TestAppliedOnPresent();
+    TestCoalescing();
+    TestBatches();
+    TestScheduledInBatch();
+    TestDebouncedBatch();
+    TestReplies();
+    TestPriorityLanes();
+    TestScheduledCommands();
+    TestLeases();
+    TestInjectedLatency();
+    TestTweenBroadcast();
+    TestReloadAndClear();
+    return test::Finish("command_engine_test");
+}
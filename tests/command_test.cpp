@@ -0,0 +1,135 @@
+#include "check.hpp"
+#include "command.hpp"
+#include <string>
+
+using namespace streamerbot;
+
+namespace {
+    CommandResult Parse(std::string_view line, PendingCommand& out) {
+        out = PendingCommand();
+        return ParseCommand(line, out);
+    }
+
+    void TestTechniqueCommands() {
+        PendingCommand command;
+        CHECK(Parse("TOGGLE Bloom", command) == CommandResult::Queued);
+        CHECK(command.action == CommandAction::Toggle);
+        CHECK(command.Target() == "Bloom");
+
+        // Keywords ignore case, and ON/OFF are ENABLE/DISABLE
+        CHECK(Parse("  on   Motion Blur  ", command) == CommandResult::Queued);
+        CHECK(command.action == CommandAction::Enable);
+        CHECK(command.Target() == "Motion Blur");
+        CHECK(Parse("Off Bloom", command) == CommandResult::Queued);
+        CHECK(command.action == CommandAction::Disable);
+
+        CHECK(Parse("TOGGLE", command) == CommandResult::MissingTarget);
+        CHECK(Parse("FLIP Bloom", command) == CommandResult::UnknownAction);
+        CHECK(Parse("TOGGLES Bloom", command) == CommandResult::UnknownAction);
+        CHECK(Parse("TOGGLE " + std::string(MAX_TARGET_LENGTH, 'x'), command) == CommandResult::TargetTooLong);
+    }
+
+    void TestLeases() {
+        PendingCommand command;
+        CHECK(Parse("ENABLE Bloom FOR 30s", command) == CommandResult::Queued);
+        CHECK(command.Target() == "Bloom");
+        CHECK(command.duration_ns == 30000000000);
+        CHECK(Parse("ENABLE Bloom FOR 250ms", command) == CommandResult::Queued);
+        CHECK(command.duration_ns == 250000000);
+        CHECK(Parse("TOGGLE Bloom FOR 5s", command) == CommandResult::LeaseNeedsEnable);
+        CHECK(Parse("ENABLE Bloom FOR soon", command) == CommandResult::InvalidDuration);
+        CHECK(Parse("ENABLE FOR 5s", command) == CommandResult::MissingTarget);
+    }
+
+    void TestUniformCommands() {
+        PendingCommand command;
+        CHECK(Parse("SET Vignette.fx/Color 1, 0.5 ,0 on", command) == CommandResult::Queued);
+        CHECK(command.action == CommandAction::Set);
+        CHECK(command.Target() == "Vignette.fx/Color");
+        CHECK(command.value_count == 4);
+        CHECK(command.values[1] == 0.5 && command.values[3] == 1.0);
+        CHECK(Parse("SET Vignette.fx/Radius", command) == CommandResult::MissingValue);
+        CHECK(Parse("SET Vignette.fx/Radius big", command) == CommandResult::InvalidValue);
+
+        std::string too_many = "SET Vignette.fx/Matrix";
+        for (size_t i = 0; i <= MAX_UNIFORM_VALUES; ++i) too_many += " 1";
+        CHECK(Parse(too_many, command) == CommandResult::TooManyValues);
+
+        CHECK(Parse("GET Vignette.fx/Radius", command) == CommandResult::ReplyPending);
+        CHECK(command.action == CommandAction::Get);
+
+        CHECK(Parse("TWEEN Vignette.fx/Color 0 1,0.5,0 2s easeInOut", command) == CommandResult::Queued);
+        CHECK(command.from_count == 1 && command.value_count == 4);
+        CHECK(command.duration_ns == 2000000000);
+        CHECK(command.easing == TweenEasing::EaseInOut);
+        CHECK(Parse("TWEEN Vignette.fx/Radius 0 1 2s bouncy", command) == CommandResult::UnknownEasing);
+        CHECK(Parse("TWEEN Vignette.fx/Radius 0 1", command) == CommandResult::MissingValue);
+        CHECK(Parse("TWEEN Vignette.fx/Color 0,0 1,1,1 1s", command) == CommandResult::InvalidValue);
+    }
+
+    void TestDebounce() {
+        PendingCommand command;
+        CHECK(Parse("DEBOUNCE Bloom 500ms", command) == CommandResult::Queued);
+        CHECK(command.action == CommandAction::Debounce);
+        CHECK(command.Target() == "Bloom");
+        CHECK(command.duration_ns == 500000000);
+        CHECK(Parse("DEBOUNCE Bloom off", command) == CommandResult::Queued);
+        CHECK(command.duration_ns == 0);
+        CHECK(Parse("DEBOUNCE Bloom", command) == CommandResult::MissingValue);
+    }
+
+    void TestSchedulesAndPriorities() {
+        PendingCommand command;
+        CHECK(Parse("AT frame+3 TOGGLE Bloom", command) == CommandResult::Queued);
+        CHECK(command.at_frame == 3 && command.at_ns == 0);
+        CHECK(command.Target() == "Bloom");
+        CHECK(Parse("at t+1.5s ENABLE Bloom", command) == CommandResult::Queued);
+        CHECK(command.at_ns == 1500000000);
+        CHECK(Parse("AT frame+x TOGGLE Bloom", command) == CommandResult::InvalidSchedule);
+        CHECK(Parse("AT tomorrow TOGGLE Bloom", command) == CommandResult::InvalidSchedule);
+        CHECK(Parse("AT frame+1", command) == CommandResult::InvalidSchedule);
+        CHECK(Parse("AT frame+1 AT frame+2 TOGGLE Bloom", command) == CommandResult::InvalidSchedule);
+        CHECK(Parse("AT frame+1 BEGIN", command) == CommandResult::InvalidSchedule);
+        // A PRIORITY prefix cannot hide either of them
+        CHECK(Parse("AT frame+5 PRIORITY HIGH AT frame+100 TOGGLE Bloom", command) == CommandResult::InvalidSchedule);
+        CHECK(Parse("AT t+1s PRIORITY LOW BEGIN", command) == CommandResult::InvalidPriority);
+
+        CHECK(Parse("PRIORITY HIGH TOGGLE Bloom", command) == CommandResult::Queued);
+        CHECK(command.priority == CommandPriority::High);
+        CHECK(Parse("PRIORITY HIGH AT frame+2 TOGGLE Bloom", command) == CommandResult::Queued);
+        CHECK(command.priority == CommandPriority::High && command.at_frame == 2);
+        CHECK(Parse("PRIORITY MEDIUM TOGGLE Bloom", command) == CommandResult::InvalidPriority);
+        CHECK(Parse("PRIORITY HIGH PRIORITY LOW TOGGLE Bloom", command) == CommandResult::InvalidPriority);
+        CHECK(Parse("PRIORITY LOW AT frame+2 PRIORITY HIGH TOGGLE Bloom", command) == CommandResult::InvalidPriority);
+        CHECK(Parse("PRIORITY LOW LOW TOGGLE Bloom", command) == CommandResult::UnknownAction);
+        CHECK(Parse("PRIORITY HIGH BEGIN", command) == CommandResult::InvalidPriority);
+        CHECK(Parse("PRIORITY HIGH COMMIT", command) == CommandResult::InvalidPriority);
+        CHECK(Parse("PRIORITY LOW ABORT", command) == CommandResult::InvalidPriority);
+
+        // Without a prefix the caller's lane is kept
+        command = PendingCommand();
+        command.priority = CommandPriority::High;
+        CHECK(ParseCommand("TOGGLE Bloom", command) == CommandResult::Queued);
+        CHECK(command.priority == CommandPriority::High);
+    }
+
+    void TestBatchControl() {
+        PendingCommand command;
+        CHECK(Parse("BEGIN", command) == CommandResult::Queued);
+        CHECK(command.action == CommandAction::BatchBegin);
+        CHECK(Parse("commit", command) == CommandResult::Queued);
+        CHECK(command.action == CommandAction::BatchCommit);
+        CHECK(Parse("ABORT", command) == CommandResult::Queued);
+        CHECK(command.action == CommandAction::BatchAbort);
+    }
+}
+
+int main() {
+    TestTechniqueCommands();
+    TestLeases();
+    TestUniformCommands();
+    TestDebounce();
+    TestSchedulesAndPriorities();
+    TestBatchControl();
+    return test::Finish("command_test");
+}
@@ -0,0 +1,79 @@
+#include "check.hpp"
+#include "line_framer.hpp"
+#include <string>
+#include <vector>
+
+using namespace streamerbot;
+
+namespace {
+    // Copies bytes into the framer as recv() would and returns the lines it completes
+    std::vector<std::string> Feed(LineFramer& framer, std::string_view bytes, bool* ok = nullptr) {
+        CHECK(bytes.size() <= framer.WriteCapacity());
+        memcpy(framer.WritePtr(), bytes.data(), bytes.size());
+        framer.Append(bytes.size());
+
+        std::vector<std::string> lines;
+        bool framed = framer.ExtractLines([&](std::string_view line) { lines.emplace_back(line); });
+        if (ok) *ok = framed;
+        return lines;
+    }
+
+    void TestPipelinedLines() {
+        LineFramer framer;
+        std::vector<std::string> lines = Feed(framer, "TOGGLE A\nENABLE B\r\n\nDISABLE C\n");
+        CHECK(lines.size() == 3);
+        CHECK(lines.size() == 3 && lines[0] == "TOGGLE A" && lines[1] == "ENABLE B" && lines[2] == "DISABLE C");
+        CHECK(framer.Size() == 0);
+    }
+
+    void TestSplitAcrossReads() {
+        LineFramer framer;
+        CHECK(Feed(framer, "TOGG").empty());
+        CHECK(Feed(framer, "LE Bl").empty());
+        std::vector<std::string> lines = Feed(framer, "oom\r\nON ");
+        CHECK(lines.size() == 1 && lines[0] == "TOGGLE Bloom");
+        CHECK(framer.Size() == 3);
+        lines = Feed(framer, "X\n");
+        CHECK(lines.size() == 1 && lines[0] == "ON X");
+    }
+
+    void TestOversizedLine() {
+        LineFramer framer;
+        bool ok = true;
+        // The tail of an oversized line is skipped up to its terminator
+        CHECK(Feed(framer, std::string(BUFFER_SIZE + 10, 'x'), &ok).empty());
+        CHECK(!ok);
+        CHECK(Feed(framer, std::string(20, 'y'), &ok).empty());
+        std::vector<std::string> lines = Feed(framer, "yyy\nTOGGLE A\n", &ok);
+        CHECK(ok);
+        CHECK(lines.size() == 1 && lines[0] == "TOGGLE A");
+
+        // A complete line that is too long is dropped, the rest of the read is kept
+        lines = Feed(framer, std::string(BUFFER_SIZE + 1, 'z') + "\nTOGGLE B\n", &ok);
+        CHECK(!ok);
+        CHECK(lines.size() == 1 && lines[0] == "TOGGLE B");
+
+        // Exactly BUFFER_SIZE is still accepted
+        lines = Feed(framer, std::string(BUFFER_SIZE, 'w') + "\n", &ok);
+        CHECK(ok);
+        CHECK(lines.size() == 1 && lines[0].size() == BUFFER_SIZE);
+    }
+
+    void TestConsume() {
+        LineFramer framer;
+        memcpy(framer.WritePtr(), "abcdef", 6);
+        framer.Append(6);
+        framer.Consume(2);
+        CHECK(framer.Size() == 4);
+        CHECK(std::string_view(framer.Data(), framer.Size()) == "cdef");
+        CHECK(framer.WriteCapacity() == RECV_BUFFER_SIZE - 4);
+    }
+}
+
+int main() {
+    TestPipelinedLines();
+    TestSplitAcrossReads();
+    TestOversizedLine();
+    TestConsume();
+    return test::Finish("line_framer_test");
+}
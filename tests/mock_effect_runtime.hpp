@@ -0,0 +1,156 @@
+#pragma once
+#include "command_engine.hpp"
+#include "effect_runtime.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace streamerbot {
+
+    // In-memory EffectRuntime for tests and benchmarks. Techniques, uniforms and textures are
+    // declared up front, technique states and uniform values are tracked per handle, and every
+    // call can be given an artificial latency to model a slow game. Present() is the
+    // deterministic frame tick: it runs what the addon's reshade_present callback runs.
+    // Like the real runtime it is only used from the thread that presents frames.
+    class MockEffectRuntime final : public EffectRuntime {
+    public:
+        // Busy-wait per call, in nanoseconds. Spinning keeps sub-millisecond delays accurate.
+        struct Latencies {
+            int64_t enumerate_ns = 0;
+            int64_t get_state_ns = 0;
+            int64_t set_state_ns = 0;
+            int64_t uniform_ns = 0;
+        };
+
+        struct Texture {
+            std::string name;
+            uint32_t width = 0;
+            uint32_t height = 0;
+        };
+
+        // Handles are 1-based indices into the catalogs
+        TechniqueHandle AddTechnique(std::string name, bool enabled = false) {
+            techniques_.push_back(Technique{ std::move(name), enabled });
+            return techniques_.size();
+        }
+
+        UniformHandle AddUniform(std::string effect_name, std::string variable_name, const UniformType& type) {
+            uniforms_.push_back(Uniform{ std::move(effect_name), std::move(variable_name), type, std::vector<uint32_t>(type.Components()) });
+            return uniforms_.size();
+        }
+
+        // Textures are not part of EffectRuntime; the catalog lets a test describe a full effect set
+        void AddTexture(std::string name, uint32_t width, uint32_t height) { textures_.push_back(Texture{ std::move(name), width, height }); }
+        const std::vector<Texture>& Textures() const { return textures_; }
+
+        void SetLatencies(const Latencies& latencies) { latencies_ = latencies; }
+
+        // Frame tick: applies queued commands as the addon does on every present
+        void Present(CommandEngine& commands) {
+            ++frames_;
+            commands.Drain(*this);
+        }
+        // Effect reload: rebuilds the engine's catalogs from this runtime
+        void Reload(CommandEngine& commands) { commands.Rebuild(*this); }
+
+        bool TechniqueState(TechniqueHandle technique) const { return techniques_[technique - 1].enabled; }
+        float UniformFloat(UniformHandle variable, size_t component = 0) const {
+            float value;
+            memcpy(&value, &uniforms_[variable - 1].values[component], sizeof(value));
+            return value;
+        }
+        int32_t UniformInt(UniformHandle variable, size_t component = 0) const { return (int32_t)uniforms_[variable - 1].values[component]; }
+
+        uint64_t Frames() const { return frames_; }
+        uint64_t SetStateCalls() const { return set_state_calls_; }
+        uint64_t UniformWrites() const { return uniform_writes_; }
+
+        void EnumerateTechniques(const std::function<void(TechniqueHandle technique, std::string_view name)>& callback) override {
+            Delay(latencies_.enumerate_ns);
+            for (size_t i = 0; i < techniques_.size(); ++i) {
+                callback(i + 1, techniques_[i].name);
+            }
+        }
+
+        bool GetTechniqueState(TechniqueHandle technique) override {
+            Delay(latencies_.get_state_ns);
+            return techniques_[technique - 1].enabled;
+        }
+
+        void SetTechniqueState(TechniqueHandle technique, bool enabled) override {
+            Delay(latencies_.set_state_ns);
+            techniques_[technique - 1].enabled = enabled;
+            ++set_state_calls_;
+        }
+
+        void EnumerateUniforms(const std::function<void(UniformHandle variable, std::string_view effect_name,
+            std::string_view variable_name, const UniformType& type)>& callback) override {
+            Delay(latencies_.enumerate_ns);
+            for (size_t i = 0; i < uniforms_.size(); ++i) {
+                callback(i + 1, uniforms_[i].effect_name, uniforms_[i].variable_name, uniforms_[i].type);
+            }
+        }
+
+        // Components are stored as 32-bit words, like the constant buffer the real runtime writes
+        void GetUniformValues(UniformHandle variable, bool* values, size_t count) override { Read(variable, values, count); }
+        void GetUniformValues(UniformHandle variable, int32_t* values, size_t count) override { Read(variable, values, count); }
+        void GetUniformValues(UniformHandle variable, uint32_t* values, size_t count) override { Read(variable, values, count); }
+        void GetUniformValues(UniformHandle variable, float* values, size_t count) override { Read(variable, values, count); }
+        void SetUniformValues(UniformHandle variable, const bool* values, size_t count) override { Write(variable, values, count); }
+        void SetUniformValues(UniformHandle variable, const int32_t* values, size_t count) override { Write(variable, values, count); }
+        void SetUniformValues(UniformHandle variable, const uint32_t* values, size_t count) override { Write(variable, values, count); }
+        void SetUniformValues(UniformHandle variable, const float* values, size_t count) override { Write(variable, values, count); }
+
+    private:
+        struct Technique {
+            std::string name;
+            bool enabled;
+        };
+
+        struct Uniform {
+            std::string effect_name;
+            std::string variable_name;
+            UniformType type;
+            std::vector<uint32_t> values;
+        };
+
+        static void Delay(int64_t ns) {
+            if (ns <= 0) return;
+            const auto until = std::chrono::steady_clock::now() + std::chrono::nanoseconds(ns);
+            while (std::chrono::steady_clock::now() < until) {}
+        }
+
+        template <typename T>
+        void Read(UniformHandle variable, T* values, size_t count) {
+            Delay(latencies_.uniform_ns);
+            const std::vector<uint32_t>& words = uniforms_[variable - 1].values;
+            for (size_t i = 0; i < count && i < words.size(); ++i) {
+                if constexpr (std::is_same_v<T, bool>) values[i] = words[i] != 0;
+                else memcpy(&values[i], &words[i], sizeof(T));
+            }
+        }
+
+        template <typename T>
+        void Write(UniformHandle variable, const T* values, size_t count) {
+            Delay(latencies_.uniform_ns);
+            std::vector<uint32_t>& words = uniforms_[variable - 1].values;
+            for (size_t i = 0; i < count && i < words.size(); ++i) {
+                if constexpr (std::is_same_v<T, bool>) words[i] = values[i] ? 1 : 0;
+                else memcpy(&words[i], &values[i], sizeof(T));
+            }
+            ++uniform_writes_;
+        }
+
+        std::vector<Technique> techniques_;
+        std::vector<Uniform> uniforms_;
+        std::vector<Texture> textures_;
+        Latencies latencies_;
+        uint64_t frames_ = 0;
+        uint64_t set_state_calls_ = 0;
+        uint64_t uniform_writes_ = 0;
+    };
+
+}
@@ -0,0 +1,119 @@
+#include "check.hpp"
+#include "mpsc_queue.hpp"
+#include <thread>
+#include <vector>
+
+using namespace streamerbot;
+
+namespace {
+    void TestFifo() {
+        MpscQueue<int, 4> queue;
+        int value = 0;
+        CHECK(!queue.TryPop(value));
+        for (int i = 0; i < 4; ++i) {
+            CHECK(queue.TryPush(i));
+        }
+        CHECK(!queue.TryPush(4));
+
+        for (int round = 0; round < 10; ++round) {
+            CHECK(queue.TryPop(value) && value == round);
+            CHECK(queue.TryPush(round + 4));
+        }
+        queue.PublishConsumerPosition();
+        CHECK(queue.ApproxSize() == 4);
+    }
+
+    void TestBatches() {
+        MpscQueue<int, 8> queue;
+        const int batch[5] = { 1, 2, 3, 4, 5 };
+        CHECK(queue.TryPushBatch(batch, 5));
+        // Only 3 slots left: nothing of the second batch goes in
+        CHECK(!queue.TryPushBatch(batch, 5));
+        CHECK(queue.TryPushBatch(batch, 3));
+        CHECK(!queue.TryPushBatch(batch, 9));
+
+        int value = 0;
+        for (int expected : { 1, 2, 3, 4, 5, 1, 2, 3 }) {
+            CHECK(queue.TryPop(value) && value == expected);
+        }
+        CHECK(!queue.TryPop(value));
+
+        // Batches wrap around the end of the ring
+        CHECK(queue.TryPushBatch(batch, 5));
+        for (int expected : { 1, 2, 3, 4, 5 }) {
+            CHECK(queue.TryPop(value) && value == expected);
+        }
+    }
+
+    // Producers push tagged values, single values and batches; the consumer checks that
+    // nothing is lost, duplicated or reordered within a producer, and that batches stay whole
+    void TestConcurrentProducers() {
+        constexpr int PRODUCERS = 3;
+        constexpr int BATCHES = 20000;
+        constexpr int BATCH_SIZE = 5;
+        MpscQueue<int, 64> queue;
+
+        std::vector<std::thread> producers;
+        for (int p = 0; p < PRODUCERS; ++p) {
+            producers.emplace_back([&queue, p] {
+                for (int b = 0; b < BATCHES; ++b) {
+                    int values[BATCH_SIZE];
+                    for (int i = 0; i < BATCH_SIZE; ++i) values[i] = (p << 24) | (b * BATCH_SIZE + i);
+                    const bool single = (b % 3) == 0;
+                    while (single ? !queue.TryPush(values[0]) : !queue.TryPushBatch(values, BATCH_SIZE)) {
+                        std::this_thread::yield();
+                    }
+                    if (single) {
+                        for (int i = 1; i < BATCH_SIZE; ++i) {
+                            while (!queue.TryPush(values[i])) std::this_thread::yield();
+                        }
+                    }
+                }
+            });
+        }
+
+        int next[PRODUCERS] = {};
+        int total = 0;
+        int in_batch = 0;                 // Values left of the batch being popped
+        int batch_producer = -1;
+        bool ordered = true;
+        bool whole_batches = true;
+        while (total < PRODUCERS * BATCHES * BATCH_SIZE) {
+            int value = 0;
+            if (!queue.TryPop(value)) {
+                std::this_thread::yield();
+                continue;
+            }
+            const int p = value >> 24;
+            const int sequence = value & 0xFFFFFF;
+            ordered = ordered && p < PRODUCERS && sequence == next[p];
+            if (p < PRODUCERS) next[p] = sequence + 1;
+
+            const bool batched = ((sequence / BATCH_SIZE) % 3) != 0;
+            if (in_batch > 0) {
+                whole_batches = whole_batches && p == batch_producer;
+                --in_batch;
+            }
+            else if (batched && sequence % BATCH_SIZE == 0) {
+                in_batch = BATCH_SIZE - 1;
+                batch_producer = p;
+            }
+            ++total;
+        }
+        for (std::thread& producer : producers) {
+            producer.join();
+        }
+
+        int value = 0;
+        CHECK(!queue.TryPop(value));
+        CHECK(ordered);
+        CHECK(whole_batches);
+    }
+}
+
+int main() {
+    TestFifo();
+    TestBatches();
+    TestConcurrentProducers();
+    return test::Finish("mpsc_queue_test");
+}
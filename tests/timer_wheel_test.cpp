@@ -0,0 +1,89 @@
+#include "check.hpp"
+#include "timer_wheel.hpp"
+#include <cstdint>
+#include <vector>
+
+using namespace streamerbot;
+
+namespace {
+    constexpr int64_t TICK_NS = 1000000;
+
+    void TestFiresInOrder() {
+        TimerWheel<int> wheel(TICK_NS);
+        wheel.Advance(0, [](int) {});
+        wheel.Schedule(5 * TICK_NS, 5);
+        wheel.Schedule(1 * TICK_NS, 1);
+        wheel.Schedule(3 * TICK_NS, 3);
+        CHECK(wheel.Size() == 3);
+
+        std::vector<int> fired;
+        auto record = [&fired](int value) { fired.push_back(value); };
+        wheel.Advance(2 * TICK_NS, record);
+        CHECK(fired == std::vector<int>({ 1 }));
+        wheel.Advance(10 * TICK_NS, record);
+        CHECK(fired == std::vector<int>({ 1, 3, 5 }));
+        CHECK(wheel.Size() == 0);
+    }
+
+    void TestPastDeadlines() {
+        TimerWheel<int> wheel(TICK_NS);
+        wheel.Advance(100 * TICK_NS, [](int) {});
+        // A deadline that already passed fires on the next tick, not immediately
+        wheel.Schedule(50 * TICK_NS, 7);
+        int fired = 0;
+        wheel.Advance(100 * TICK_NS, [&fired](int) { ++fired; });
+        CHECK(fired == 0);
+        wheel.Advance(101 * TICK_NS, [&fired](int) { ++fired; });
+        CHECK(fired == 1);
+    }
+
+    // Timers on every level cascade down and fire within one tick of their deadline
+    void TestCascading() {
+        TimerWheel<int64_t> wheel(TICK_NS);
+        const int64_t start = 12345 * TICK_NS;
+        wheel.Advance(start, [](int64_t) {});
+
+        std::vector<int64_t> deadlines;
+        for (int64_t ticks : { 1, 63, 64, 65, 4095, 4096, 4097, 262143, 262144, 300000, 16777216 }) {
+            deadlines.push_back(start + ticks * TICK_NS);
+            wheel.Schedule(deadlines.back(), deadlines.back());
+        }
+
+        size_t fired = 0;
+        bool on_time = true;
+        int64_t now = start;
+        while (wheel.Size() > 0 && now < start + 20000000 * TICK_NS) {
+            now += 997 * TICK_NS;
+            wheel.Advance(now, [&](int64_t deadline) {
+                ++fired;
+                on_time = on_time && deadline <= now && deadline > now - 997 * TICK_NS - TICK_NS;
+            });
+        }
+        CHECK(fired == deadlines.size());
+        CHECK(on_time);
+    }
+
+    void TestClear() {
+        TimerWheel<int> wheel(TICK_NS);
+        wheel.Advance(0, [](int) {});
+        wheel.Schedule(5 * TICK_NS, 1);
+        wheel.Schedule(100000 * TICK_NS, 2);
+        wheel.Clear();
+        CHECK(wheel.Size() == 0);
+
+        int fired = 0;
+        wheel.Advance(200000 * TICK_NS, [&fired](int) { ++fired; });
+        CHECK(fired == 0);
+        wheel.Schedule(200001 * TICK_NS, 3);
+        wheel.Advance(200001 * TICK_NS, [&fired](int) { ++fired; });
+        CHECK(fired == 1);
+    }
+}
+
+int main() {
+    TestFiresInOrder();
+    TestPastDeadlines();
+    TestCascading();
+    TestClear();
+    return test::Finish("timer_wheel_test");
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include "transport.hpp"
+#include "websocket.hpp"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace streamerbot {
+    namespace test {
+
+        // Upgrade request with the key from RFC 6455 section 1.3
+        constexpr const char* WEBSOCKET_UPGRADE = "GET / HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\n"
+            "Connection: Upgrade\r\nSec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+
+        // Builds a masked client frame, as a browser would send it
+        inline std::string ClientFrame(uint8_t opcode, std::string_view payload, const uint8_t mask[4], bool fin = true) {
+            std::string frame;
+            websocket::AppendFrame(frame, opcode, payload);
+            if (!fin) frame[0] = (char)(frame[0] & 0x7F);
+            size_t header_size = frame.size() - payload.size();
+            frame[1] = (char)(frame[1] | 0x80);
+            frame.insert(header_size, (const char*)mask, 4);
+            for (size_t i = 0; i < payload.size(); ++i) {
+                frame[header_size + 4 + i] = (char)(frame[header_size + 4 + i] ^ mask[i % 4]);
+            }
+            return frame;
+        }
+
+        // Client end of a WebSocket connection over any transport
+        class WebSocketClient {
+        public:
+            WebSocketClient(Transport& transport, SocketHandle socket) : transport_(transport), socket_(socket) {}
+            WebSocketClient(const WebSocketClient&) = delete;
+            WebSocketClient& operator=(const WebSocketClient&) = delete;
+            ~WebSocketClient() {
+                if (socket_ != INVALID_SOCKET_HANDLE) transport_.Close(socket_);
+            }
+
+            // Sends the upgrade request and waits for the 101 response
+            bool Upgrade(int64_t timeout_ms = 5000) {
+                if (!Send(WEBSOCKET_UPGRADE)) return false;
+                const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+                size_t end;
+                while ((end = buffer_.find("\r\n\r\n")) == std::string::npos) {
+                    if (!Fill(deadline)) return false;
+                }
+                const bool switched = buffer_.compare(0, 13, "HTTP/1.1 101 ") == 0;
+                buffer_.erase(0, end + 4);
+                return switched;
+            }
+
+            bool SendText(std::string_view text, bool fin = true, uint8_t opcode = websocket::OP_TEXT) {
+                const uint8_t mask[4] = { 0x37, 0xFA, 0x21, 0x3D };
+                return Send(ClientFrame(opcode, text, mask, fin));
+            }
+
+            // Reads the next server frame. Returns false on timeout or when the connection closed
+            // before a whole frame arrived.
+            bool ReadFrame(uint8_t& opcode, std::string& payload, int64_t timeout_ms = 5000) {
+                const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+                websocket::FrameHeader frame;
+                while (!websocket::ParseFrameHeader((const uint8_t*)buffer_.data(), buffer_.size(), frame) ||
+                    buffer_.size() < frame.header_size + frame.payload_size) {
+                    if (!Fill(deadline)) return false;
+                }
+                opcode = frame.opcode;
+                payload.assign(buffer_, frame.header_size, (size_t)frame.payload_size);
+                buffer_.erase(0, frame.header_size + (size_t)frame.payload_size);
+                return true;
+            }
+
+            // Close code of a close frame payload, or 0 if it has none
+            static uint16_t CloseCode(const std::string& payload) {
+                if (payload.size() < 2) return 0;
+                return (uint16_t)(((uint8_t)payload[0] << 8) | (uint8_t)payload[1]);
+            }
+
+            bool Send(std::string_view data) {
+                while (!data.empty()) {
+                    IoResult sent = transport_.Send(socket_, data.data(), data.size());
+                    if (sent.status == IoStatus::Ok) data.remove_prefix(sent.bytes);
+                    else if (sent.status == IoStatus::WouldBlock) std::this_thread::yield();
+                    else return false;
+                }
+                return true;
+            }
+
+        private:
+            bool Fill(std::chrono::steady_clock::time_point deadline) {
+                char chunk[4096];
+                while (true) {
+                    IoResult received = transport_.Recv(socket_, chunk, sizeof(chunk));
+                    if (received.status == IoStatus::Ok) {
+                        buffer_.append(chunk, received.bytes);
+                        return true;
+                    }
+                    if (received.status != IoStatus::WouldBlock || std::chrono::steady_clock::now() > deadline) return false;
+                    std::this_thread::yield();
+                }
+            }
+
+            Transport& transport_;
+            SocketHandle socket_;
+            std::string buffer_;
+        };
+
+    }
+}
@@ -0,0 +1,154 @@
+#include "check.hpp"
+#include "command_engine.hpp"
+#include "loopback_transport.hpp"
+#include "mock_effect_runtime.hpp"
+#include "server.hpp"
+#include "websocket_client.hpp"
+#include <atomic>
+#include <initializer_list>
+#include <string>
+#include <thread>
+
+using namespace streamerbot;
+
+namespace {
+    constexpr int PORT = 7777;
+
+    LogRing g_log;
+
+    // A server on the loopback transport, running on its own thread
+    struct Fixture {
+        LoopbackTransport transport;
+        MockEffectRuntime runtime;
+        CommandEngine commands{ g_log };
+        Server server{ transport, commands, g_log };
+        std::atomic<bool> running{ true };
+        std::thread thread;
+
+        Fixture() {
+            runtime.AddTechnique("Bloom");
+            runtime.Reload(commands);
+            server.Open(PORT);
+            thread = std::thread([this] { server.Run([this] { return running.load(); }); });
+        }
+        ~Fixture() {
+            running = false;
+            server.Wake();
+            thread.join();
+        }
+
+        test::WebSocketClient Connect() { return test::WebSocketClient(transport, transport.Connect(PORT)); }
+    };
+
+    bool ReadText(test::WebSocketClient& client, const std::string& expected) {
+        uint8_t opcode;
+        std::string payload;
+        return client.ReadFrame(opcode, payload) && opcode == websocket::OP_TEXT && payload == expected;
+    }
+
+    uint16_t ReadClose(test::WebSocketClient& client) {
+        uint8_t opcode;
+        std::string payload;
+        if (!client.ReadFrame(opcode, payload) || opcode != websocket::OP_CLOSE) return 0;
+        return test::WebSocketClient::CloseCode(payload);
+    }
+
+    void TestCommands() {
+        Fixture f;
+        test::WebSocketClient client = f.Connect();
+        CHECK(client.Upgrade());
+        CHECK(client.SendText("TOGGLE Bloom"));
+        CHECK(ReadText(client, "OK"));
+
+        // One message can carry several lines, and a message can span fragments
+        CHECK(client.SendText("ENABLE Bloom\nDISABLE Bloom"));
+        CHECK(ReadText(client, "OK"));
+        CHECK(ReadText(client, "OK"));
+        CHECK(client.SendText("TOGGLE ", false));
+        CHECK(client.SendText("Bloom", true, websocket::OP_CONTINUATION));
+        CHECK(ReadText(client, "OK"));
+        CHECK(f.commands.Queued() == 4);
+    }
+
+    void TestMessageLimits() {
+        Fixture f;
+        {
+            // The largest message that fits is still served
+            test::WebSocketClient client = f.Connect();
+            CHECK(client.Upgrade());
+            CHECK(client.SendText(std::string(websocket::MAX_MESSAGE_SIZE - 12, '\n') + "TOGGLE Bloom"));
+            CHECK(ReadText(client, "OK"));
+        }
+        {
+            test::WebSocketClient client = f.Connect();
+            CHECK(client.Upgrade());
+            CHECK(client.SendText(std::string(websocket::MAX_MESSAGE_SIZE + 1, '\n')));
+            CHECK(ReadClose(client) == websocket::CLOSE_TOO_BIG);
+        }
+        {
+            // Header and payload together past the receive buffer
+            test::WebSocketClient client = f.Connect();
+            CHECK(client.Upgrade());
+            CHECK(client.SendText(std::string(RECV_BUFFER_SIZE, '\n')));
+            CHECK(ReadClose(client) == websocket::CLOSE_TOO_BIG);
+        }
+        {
+            // Fragments that only exceed the limit once reassembled
+            test::WebSocketClient client = f.Connect();
+            CHECK(client.Upgrade());
+            CHECK(client.SendText(std::string(websocket::MAX_MESSAGE_SIZE / 2, '\n'), false));
+            CHECK(client.SendText(std::string(websocket::MAX_MESSAGE_SIZE / 2 + 2, '\n'), true, websocket::OP_CONTINUATION));
+            CHECK(ReadClose(client) == websocket::CLOSE_TOO_BIG);
+        }
+    }
+
+    // Sends data after an upgrade and returns the close code the server answers with
+    uint16_t CloseCodeFor(Fixture& f, std::initializer_list<std::string> frames) {
+        test::WebSocketClient client = f.Connect();
+        if (!client.Upgrade()) return 0;
+        for (const std::string& frame : frames) {
+            if (!client.Send(frame)) return 0;
+        }
+        return ReadClose(client);
+    }
+
+    void TestProtocolErrors() {
+        Fixture f;
+        const uint8_t mask[4] = { 0x37, 0xFA, 0x21, 0x3D };
+        using test::ClientFrame;
+
+        // Control frames carry at most 125 bytes and cannot be fragmented
+        CHECK(CloseCodeFor(f, { ClientFrame(websocket::OP_PING, std::string(126, 'p'), mask) }) == websocket::CLOSE_PROTOCOL_ERROR);
+        CHECK(CloseCodeFor(f, { ClientFrame(websocket::OP_PING, "p", mask, false) }) == websocket::CLOSE_PROTOCOL_ERROR);
+        // A continuation needs an unfinished message, and a new message needs the last one finished
+        CHECK(CloseCodeFor(f, { ClientFrame(websocket::OP_CONTINUATION, "TOGGLE Bloom", mask) }) == websocket::CLOSE_PROTOCOL_ERROR);
+        CHECK(CloseCodeFor(f, { ClientFrame(websocket::OP_TEXT, "TOGGLE ", mask, false),
+            ClientFrame(websocket::OP_TEXT, "Bloom", mask) }) == websocket::CLOSE_PROTOCOL_ERROR);
+        CHECK(CloseCodeFor(f, { ClientFrame(websocket::OP_TEXT, "TOGGLE ", mask, false),
+            ClientFrame(websocket::OP_BINARY, "Bloom", mask) }) == websocket::CLOSE_PROTOCOL_ERROR);
+
+        // Text must be UTF-8, checked over the whole message
+        CHECK(CloseCodeFor(f, { ClientFrame(websocket::OP_TEXT, "TOGGLE Bloo\xFF", mask) }) == websocket::CLOSE_INVALID_PAYLOAD);
+        CHECK(CloseCodeFor(f, { ClientFrame(websocket::OP_TEXT, "TOGGLE \xE2", mask, false),
+            ClientFrame(websocket::OP_CONTINUATION, "\x82", mask) }) == websocket::CLOSE_INVALID_PAYLOAD);
+        CHECK(f.commands.Queued() == 0);
+
+        // A code point split across fragments, with a ping between them, is fine
+        test::WebSocketClient client = f.Connect();
+        CHECK(client.Upgrade());
+        CHECK(client.SendText("TOGGLE Bloom \xE2", false));
+        CHECK(client.Send(ClientFrame(websocket::OP_PING, std::string(125, 'p'), mask)));
+        CHECK(client.SendText("\x82\xAC", true, websocket::OP_CONTINUATION));
+        uint8_t opcode;
+        std::string payload;
+        CHECK(client.ReadFrame(opcode, payload) && opcode == websocket::OP_PONG && payload.size() == 125);
+        CHECK(ReadText(client, "OK"));
+    }
+}
+
+int main() {
+    TestCommands();
+    TestMessageLimits();
+    TestProtocolErrors();
+    return test::Finish("websocket_server_test");
+}
@@ -0,0 +1,109 @@
+#include "check.hpp"
+#include "websocket.hpp"
+#include "websocket_client.hpp"
+#include <string>
+#include <vector>
+
+using namespace streamerbot;
+
+namespace {
+    using test::ClientFrame;
+
+    void TestHeaderLengths() {
+        const uint8_t mask[4] = { 0x12, 0x34, 0x56, 0x78 };
+        for (size_t size : { (size_t)0, (size_t)125, (size_t)126, (size_t)65535, (size_t)65536 }) {
+            std::string frame = ClientFrame(websocket::OP_TEXT, std::string(size, 'a'), mask);
+            websocket::FrameHeader header;
+            CHECK(websocket::ParseFrameHeader((const uint8_t*)frame.data(), frame.size(), header));
+            CHECK(header.fin && header.masked && header.opcode == websocket::OP_TEXT);
+            CHECK(header.payload_size == size);
+            CHECK(header.header_size + size == frame.size());
+            CHECK(memcmp(header.mask, mask, 4) == 0);
+
+            // Every truncated header asks for more bytes
+            for (size_t cut = 0; cut < header.header_size; ++cut) {
+                websocket::FrameHeader partial;
+                CHECK(!websocket::ParseFrameHeader((const uint8_t*)frame.data(), cut, partial));
+            }
+        }
+
+        std::string fragment = ClientFrame(websocket::OP_TEXT, "TOG", mask, false);
+        websocket::FrameHeader header;
+        CHECK(websocket::ParseFrameHeader((const uint8_t*)fragment.data(), fragment.size(), header));
+        CHECK(!header.fin);
+    }
+
+    void TestUnmask() {
+        const uint8_t mask[4] = { 0xA1, 0x00, 0xFF, 0x3C };
+        // Sizes around the 16-byte SIMD step exercise both the vector loop and the tail
+        for (size_t size : { 0, 1, 3, 15, 16, 17, 31, 64, 1000 }) {
+            std::vector<uint8_t> plain(size);
+            for (size_t i = 0; i < size; ++i) plain[i] = (uint8_t)(i * 7 + 3);
+            std::vector<uint8_t> data = plain;
+            for (size_t i = 0; i < size; ++i) data[i] ^= mask[i % 4];
+
+            websocket::Unmask(data.data(), size, mask);
+            CHECK(data == plain);
+        }
+    }
+
+    void TestServerFrames() {
+        std::string out;
+        websocket::AppendFrame(out, websocket::OP_TEXT, "OK");
+        CHECK(out == std::string("\x81\x02OK", 4));
+
+        out.clear();
+        websocket::AppendFrame(out, websocket::OP_TEXT, std::string(300, 'x'));
+        CHECK(out.size() == 4 + 300);
+        CHECK((uint8_t)out[1] == 126 && (uint8_t)out[2] == 1 && (uint8_t)out[3] == 44);
+
+        out.clear();
+        websocket::AppendClose(out, websocket::CLOSE_TOO_BIG);
+        CHECK(out == std::string("\x88\x02\x03\xF1", 4));
+    }
+
+    void TestHandshake() {
+        // The example from RFC 6455 section 1.3
+        std::string out;
+        CHECK(websocket::Handshake("GET /chat HTTP/1.1\r\nHost: server.example.com\r\nUpgrade: websocket\r\n"
+            "Connection: keep-alive, Upgrade\r\nSec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n", out));
+        CHECK(out.find("HTTP/1.1 101 ") == 0);
+        CHECK(out.find("Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n") != std::string::npos);
+
+        out.clear();
+        CHECK(!websocket::Handshake("GET / HTTP/1.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+            "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 8\r\n", out));
+        CHECK(out.find("HTTP/1.1 400 ") == 0);
+    }
+
+    void TestMessageLimit() {
+        // The largest message still fits in the receive buffer with the largest header
+        CHECK(websocket::MAX_MESSAGE_SIZE + websocket::MAX_FRAME_HEADER_SIZE <= RECV_BUFFER_SIZE);
+    }
+
+    void TestUtf8() {
+        CHECK(websocket::IsValidUtf8(""));
+        CHECK(websocket::IsValidUtf8("TOGGLE Bloom, a line longer than one 8-byte step"));
+        CHECK(websocket::IsValidUtf8("SET Caf\xC3\xA9.fx/\xE2\x82\xAC 1 \xF0\x9F\x8E\xA5"));
+        CHECK(websocket::IsValidUtf8("\xED\x9F\xBF \xF4\x8F\xBF\xBF"));         // U+D7FF and U+10FFFF
+        CHECK(!websocket::IsValidUtf8("TOGGLE Bloo\xFF"));
+        CHECK(!websocket::IsValidUtf8("\xC0\xAF"));                            // Overlong '/'
+        CHECK(!websocket::IsValidUtf8("\xE0\x80\xAF"));
+        CHECK(!websocket::IsValidUtf8("\xF0\x80\x80\xAF"));
+        CHECK(!websocket::IsValidUtf8("\xED\xA0\x80"));                        // Surrogate U+D800
+        CHECK(!websocket::IsValidUtf8("\xF4\x90\x80\x80"));                    // Past U+10FFFF
+        CHECK(!websocket::IsValidUtf8("\x80"));                                // Lone continuation byte
+        CHECK(!websocket::IsValidUtf8("\xE2\x82"));                            // Cut off at the end
+        CHECK(!websocket::IsValidUtf8("\xE2\x82 more text after it"));
+    }
+}
+
+int main() {
+    TestHeaderLengths();
+    TestUnmask();
+    TestServerFrames();
+    TestHandshake();
+    TestMessageLimit();
+    TestUtf8();
+    return test::Finish("websocket_test");
+}